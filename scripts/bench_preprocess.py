@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+# Throughput benchmark for preprocess on reads simulated by gen-duplex; run with "make bench-preprocess".
+# Each thread count is timed end to end, and lt_process() throughput is taken from the --stats report.
+# Use --record to save the results and --baseline to compare a later build against them.
+
+import argparse, json, os, subprocess, sys, tempfile, time
+
+def run(prog, threads, r1, r2, stats):
+	t = time.time()
+	with open(os.devnull, "w") as null:
+		subprocess.check_call([prog, "-v0", "-t%d" % threads, "--stats", stats, r1, r2], stdout=null)
+	wall = time.time() - t
+	with open(stats) as fp:
+		st = json.load(fp)
+	proc = st["time"]["process"]
+	return {
+		"threads": threads,
+		"wall": wall,
+		"pairs_per_sec": st["pairs"] / wall,
+		"bases_per_sec": st["bases"]["in"] / wall,
+		"process_pairs_per_cpu_sec": st["pairs"] / proc["cpu"] if proc["cpu"] > 0 else 0.0,
+		"ntrim": proc["ntrim"], "adapter": proc["adapter"], "barcode": proc["barcode"], "merge": proc["merge"], "format": proc["format"],
+	}, st
+
+def main():
+	root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+	ap = argparse.ArgumentParser(description="Benchmark preprocess on simulated duplex reads")
+	ap.add_argument("-n", "--pairs", type=int, default=500000, help="number of simulated pairs [500000]")
+	ap.add_argument("-s", "--seed", type=int, default=11, help="simulation seed [11]")
+	ap.add_argument("-t", "--threads", default="1,2,4", help="comma-separated thread counts [1,2,4]")
+	ap.add_argument("-g", "--gen-args", default="", help="extra options passed to gen-duplex")
+	ap.add_argument("--record", metavar="FILE", help="save the results as TSV to FILE")
+	ap.add_argument("--baseline", metavar="FILE", help="compare with the results saved by --record")
+	args = ap.parse_args()
+
+	cols = ["threads", "wall", "pairs_per_sec", "bases_per_sec", "process_pairs_per_cpu_sec", "ntrim", "adapter", "barcode", "merge", "format"]
+	base = {}
+	if args.baseline:
+		with open(args.baseline) as fp:
+			hdr = fp.readline().rstrip("\n").split("\t")
+			for line in fp:
+				r = dict(zip(hdr, line.rstrip("\n").split("\t")))
+				base[int(r["threads"])] = r
+
+	tmp = tempfile.mkdtemp(prefix="bench-preprocess.")
+	r1, r2, stats = os.path.join(tmp, "R1.fq"), os.path.join(tmp, "R2.fq"), os.path.join(tmp, "stats.json")
+	subprocess.check_call([os.path.join(root, "gen-duplex"), "-n%d" % args.pairs, "-s%d" % args.seed, "-1", r1, "-2", r2] +
+			args.gen_args.split() + [os.path.join(root, "references", "Tn5_barcodes.txt")])
+
+	res, types = [], None
+	for t in [int(x) for x in args.threads.split(",")]:
+		r, st = run(os.path.join(root, "preprocess"), t, r1, r2, stats)
+		res.append(r)
+		if types is None: types = st["types"]["output"]
+		elif types != st["types"]["output"]:
+			sys.exit("[E::bench] the output differs between thread counts")
+	for f in (r1, r2, stats): os.unlink(f)
+	os.rmdir(tmp)
+
+	print("%-12s %8s %12s %12s %12s %9s" % ("threads", "wall", "pairs/s", "Mbases/s", "proc/cpu-s", "baseline"))
+	for r in res:
+		b = base.get(r["threads"])
+		ratio = "%8.2fx" % (r["pairs_per_sec"] / float(b["pairs_per_sec"])) if b else "%9s" % "-"
+		print("%-12d %8.2f %12.0f %12.1f %12.0f %s" % (r["threads"], r["wall"], r["pairs_per_sec"], r["bases_per_sec"] / 1e6, r["process_pairs_per_cpu_sec"], ratio))
+	print("\nlt_process sub-stage seconds (%d thread%s):" % (res[0]["threads"], "" if res[0]["threads"] == 1 else "s"))
+	print("  " + "  ".join("%s %.3f" % (c, res[0][c]) for c in cols[5:]))
+	print("\npair types:")
+	for name, v in types.items():
+		if v["pairs"] > 0: print("  %-20s %10d %8.4f" % (name, v["pairs"], v["rate"]))
+
+	if args.record:
+		with open(args.record, "w") as fp:
+			fp.write("\t".join(cols) + "\n")
+			for r in res:
+				fp.write("\t".join(str(r[c]) if c == "threads" else "%.4f" % r[c] for c in cols) + "\n")
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+# Read the binary QC columns written by "preprocess -Q". The file is memory-mapped and each chunk is returned
+# as a dict of memoryviews over the mapping, so nothing is parsed or copied; numpy.frombuffer() accepts them as is.
+# Run as a script to print the pairs per type, or every row as TSV with --tsv.
+
+import argparse, mmap, struct, sys
+
+COLS = ["merge_pos_l", "merge_pos_r", "olig_pos_f", "olig_pos_r", "len1", "len2", "bc_id_f", "bc_id_r", "cell"]
+CHUNK_MAGIC = 0x4b51544c
+
+def chunks(fn):
+	fp = open(fn, "rb")
+	mm = mmap.mmap(fp.fileno(), 0, access=mmap.ACCESS_READ)
+	mv = memoryview(mm)
+	if mv[:8] != b"LTQC\1\0\0\0":
+		sys.exit("[E::qc_columns] '%s' is not a preprocess QC file" % fn)
+	off = 8
+	while off < len(mv):
+		magic, n, first = struct.unpack_from("=IIQ", mv, off)
+		if magic != CHUNK_MAGIC:
+			sys.exit("[E::qc_columns] bad chunk header at offset %d; the file may come from a machine of another byte order" % off)
+		p, c = off + 16, {"first": first, "n": n}
+		for name in COLS:
+			c[name] = mv[p : p + 4 * n].cast("i")
+			p += 4 * n
+		c["type"] = mv[p : p + n]
+		off = (p + n + 7) & ~7
+		yield c
+
+def main():
+	ap = argparse.ArgumentParser(description="Summarize or dump the binary QC columns of preprocess -Q")
+	ap.add_argument("--tsv", action="store_true", help="print the pair index, type and all columns, one pair per line")
+	ap.add_argument("qc", help="file written by preprocess -Q")
+	args = ap.parse_args()
+	cnt, n_pairs = {}, 0
+	for c in chunks(args.qc):
+		n_pairs += c["n"]
+		if args.tsv:
+			cols = [c[name] for name in COLS]
+			for i in range(c["n"]):
+				sys.stdout.write("%d\t%d\t%s\n" % (c["first"] + i, c["type"][i], "\t".join(str(x[i]) for x in cols)))
+		else:
+			for t in c["type"]:
+				cnt[t] = cnt.get(t, 0) + 1
+	if not args.tsv:
+		print("pairs\t%d" % n_pairs)
+		for t in sorted(cnt):
+			print("type %d\t%d\t%.6f" % (t, cnt[t], cnt[t] / n_pairs))
+
+if __name__ == "__main__":
+	main()
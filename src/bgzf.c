@@ -158,9 +158,9 @@ BGZF *bgzf_open(const char *path, const char *mode)
 		if ((fpr = _bgzf_open(path, "r")) == 0) return 0;
 		fp = bgzf_read_init();
 		fp->fp = fpr;
-	} else if (strchr(mode, 'w') || strchr(mode, 'W')) {
+	} else if (strchr(mode, 'w') || strchr(mode, 'W') || strchr(mode, 'a')) {
 		FILE *fpw;
-		if ((fpw = fopen(path, "w")) == 0) return 0;
+		if ((fpw = fopen(path, strchr(mode, 'a')? "a" : "w")) == 0) return 0;
 		fp = bgzf_write_init(mode2level(mode));
 		fp->fp = fpw;
 	}
@@ -225,33 +225,34 @@ static int deflate_block(BGZF *fp, int block_length)
 	return comp_size;
 }
 
-// Inflate the block in fp->compressed_block into fp->uncompressed_block
-static int inflate_block(BGZF* fp, int block_length)
+int bgzf_inflate_raw(const void *src, int slen, void *dst)
 {
 	z_stream zs;
 	zs.zalloc = NULL;
 	zs.zfree = NULL;
-	zs.next_in = (Bytef*)fp->compressed_block + 18;
-	zs.avail_in = block_length - 16;
-	zs.next_out = (Bytef*)fp->uncompressed_block;
+	zs.next_in = (Bytef*)src + 18;
+	zs.avail_in = slen - 16;
+	zs.next_out = (Bytef*)dst;
 	zs.avail_out = BGZF_MAX_BLOCK_SIZE;
 
-	if (inflateInit2(&zs, -15) != Z_OK) {
-		fp->errcode |= BGZF_ERR_ZLIB;
-		return -1;
-	}
+	if (inflateInit2(&zs, -15) != Z_OK) return -1;
 	if (inflate(&zs, Z_FINISH) != Z_STREAM_END) {
 		inflateEnd(&zs);
-		fp->errcode |= BGZF_ERR_ZLIB;
-		return -1;
-	}
-	if (inflateEnd(&zs) != Z_OK) {
-		fp->errcode |= BGZF_ERR_ZLIB;
 		return -1;
 	}
+	if (inflateEnd(&zs) != Z_OK) return -1;
 	return zs.total_out;
 }
 
+// Inflate the block in fp->compressed_block into fp->uncompressed_block
+static int inflate_block(BGZF* fp, int block_length)
+{
+	int ret;
+	if ((ret = bgzf_inflate_raw(fp->compressed_block, block_length, fp->uncompressed_block)) < 0)
+		fp->errcode |= BGZF_ERR_ZLIB;
+	return ret;
+}
+
 static int check_header(const uint8_t *header)
 {
 	return (header[0] == 31 && header[1] == 139 && header[2] == 8 && (header[3] & 4) != 0
@@ -354,6 +355,26 @@ int bgzf_read_block(BGZF *fp)
 	return 0;
 }
 
+int bgzf_read_raw(BGZF *fp, void *data)
+{
+	uint8_t *block = (uint8_t*)data;
+	int count, block_length;
+	fp->block_address = _bgzf_tell((_bgzf_file_t)fp->fp);
+	count = _bgzf_read(fp->fp, block, BLOCK_HEADER_LENGTH);
+	if (count == 0) return 0;
+	if (count != BLOCK_HEADER_LENGTH || !check_header(block)) {
+		fp->errcode |= BGZF_ERR_HEADER;
+		return -1;
+	}
+	block_length = unpackInt16(&block[16]) + 1;
+	count = _bgzf_read(fp->fp, &block[BLOCK_HEADER_LENGTH], block_length - BLOCK_HEADER_LENGTH);
+	if (count != block_length - BLOCK_HEADER_LENGTH) {
+		fp->errcode |= BGZF_ERR_IO;
+		return -1;
+	}
+	return block_length;
+}
+
 ssize_t bgzf_read(BGZF *fp, void *data, ssize_t length)
 {
 	ssize_t bytes_read = 0;
@@ -421,7 +442,10 @@ static int worker_aux(worker_t *w)
 		memcpy(w->mt->blk[i], w->buf, clen);
 		w->mt->len[i] = clen;
 	}
-	__sync_fetch_and_add(&w->mt->proc_cnt, 1);
+	pthread_mutex_lock(&w->mt->lock);
+	++w->mt->proc_cnt;
+	pthread_cond_broadcast(&w->mt->cv);
+	pthread_mutex_unlock(&w->mt->lock);
 	return 0;
 }
 
@@ -504,7 +528,10 @@ static int mt_flush(BGZF *fp)
 	// worker 0 is doing things here
 	worker_aux(&mt->w[0]);
 	// wait for all the threads to complete
-	while (mt->proc_cnt < mt->n_threads);
+	pthread_mutex_lock(&mt->lock);
+	while (mt->proc_cnt < mt->n_threads)
+		pthread_cond_wait(&mt->cv, &mt->lock);
+	pthread_mutex_unlock(&mt->lock);
 	// dump data to disk
 	for (i = 0; i < mt->n_threads; ++i) fp->errcode |= mt->w[i].errcode;
 	for (i = 0; i < mt->curr; ++i)
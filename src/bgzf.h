@@ -197,6 +197,27 @@ extern "C" {
 	 */
 	int bgzf_read_block(BGZF *fp);
 
+	/**
+	 * Read the next BGZF block without decompressing it. The address of
+	 * the block is kept in fp->block_address.
+	 *
+	 * @param fp     BGZF file handler opened for reading
+	 * @param data   buffer of at least BGZF_MAX_BLOCK_SIZE bytes
+	 * @return       length of the raw block; 0 on end-of-file and -1 on error
+	 */
+	int bgzf_read_raw(BGZF *fp, void *data);
+
+	/**
+	 * Decompress a block read by bgzf_read_raw(). It does not touch any
+	 * BGZF handler and can be called from multiple threads.
+	 *
+	 * @param src    raw block
+	 * @param slen   length of the raw block
+	 * @param dst    buffer of at least BGZF_MAX_BLOCK_SIZE bytes
+	 * @return       length of the decompressed data; -1 on error
+	 */
+	int bgzf_inflate_raw(const void *src, int slen, void *dst);
+
 #ifdef BGZF_MT
 	/**
 	 * Enable multi-threading (only effective on writing)
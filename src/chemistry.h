@@ -0,0 +1,37 @@
+#ifndef LT_CHEMISTRY_H
+#define LT_CHEMISTRY_H
+
+/* Adapters, transposon and Tn5 barcodes of the library chemistry. Both preprocess and gen-matchers include
+ * this file; gen-matchers specializes the matchers for these sequences at build time. */
+
+#define LT_ADAP_PEN     1 // default max penalty and min length of an adapter hit
+#define LT_ADAP_MIN_LEN 3
+
+const char *lt_adapter1 = "AGATCGGAAGAGCACACGTCTGAACTCCAGTCAC"; // Illumina 3'-end adapter
+const char *lt_adapter2 = "AGATCGGAAGAGCGTCGTGTAGGGAAAGAGTGTAGATCTCGGTGGTCGCCGTATCATT";
+const char *lt_oligo_for= "AGATGTGTATAAGAGACAG"; // 19bp transposon
+const char *lt_oligo_rev= "CTGTCTCTTATACACATCT";
+
+//By Bowen Jin
+const char *Tn5_barcode[] = {
+"GGCACCGAAAA",
+"CTCGGCGATAAA",
+"GGTGGAGCATAA",
+"CGAGCGCATTAA",
+"AGCCCGGTTATA",
+"TCGGCACCAATA",
+"GCCTGTGGATTA",
+"GCGACCCTTTTA",
+"GCATGCGGTAAT",
+"GCGTTGCCATAT",
+"GGCCGCATTTAT",
+"ACCGCCTCTATT",
+"CCGTGCCAAAAT",
+"TCTCCGGGAATT",
+"CCGCGCTTATTT",
+"CTGAGCTCGTTTT",
+0
+};
+//
+
+#endif
@@ -0,0 +1,237 @@
+/* Simulate paired-end reads from Tn5-based duplex libraries, for benchmarking preprocess. Each fragment is
+	BC1 + transposon + insert + revcomp(transposon) + revcomp(BC2), read from both ends and followed by the
+	Illumina adapters where the fragment is shorter than the read. The output only depends on the options. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+static const char *gd_oligo   = "AGATGTGTATAAGAGACAG"; // 19bp transposon
+static const char *gd_adapter[2] = {
+	"AGATCGGAAGAGCACACGTCTGAACTCCAGTCAC",
+	"AGATCGGAAGAGCGTCGTGTAGGGAAAGAGTGTAGATCTCGGTGGTCGCCGTATCATT"
+};
+
+enum gd_class_e { GD_FULL = 0, GD_PARTIAL, GD_CONTAINED, GD_NONE, GD_N_CLASSES }; // overlap between the two reads
+static const char *gd_class_str[] = { "full", "partial", "contained", "none" };
+
+/*****************
+ * Random number *
+ *****************/
+
+static uint64_t gd_x = 11;
+
+static inline uint64_t gd_rand(void) // splitmix64; the same stream on every platform
+{
+	uint64_t z = (gd_x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+static inline double gd_drand(void) { return (gd_rand() >> 11) * (1.0 / 9007199254740992.0); }
+static inline int gd_irand(int lo, int hi) { return lo + (int)(gd_rand() % (uint64_t)(hi - lo + 1)); } // in [lo,hi]
+
+/************
+ * Sequence *
+ ************/
+
+static void gd_revcomp(int l, const char *f, char *r)
+{
+	int i;
+	for (i = 0; i < l; ++i) {
+		int c = f[l - 1 - i];
+		r[i] = c == 'A'? 'T' : c == 'C'? 'G' : c == 'G'? 'C' : c == 'T'? 'A' : 'N';
+	}
+}
+
+static void gd_random_seq(int l, char *s)
+{
+	int i;
+	for (i = 0; i < l; ++i) s[i] = "ACGT"[gd_rand() & 3];
+}
+
+// append _l_ bases of _s_ to _dst_ at _*n_
+static inline void gd_cat(char *dst, int *n, int l, const char *s)
+{
+	memcpy(dst + *n, s, l);
+	*n += l;
+}
+
+typedef struct {
+	int n_bc, l_read;
+	char **bc;
+	double err, no_bc, n_rate;
+	double mix[GD_N_CLASSES]; // cumulative
+} gd_opt_t;
+
+// add sequencing errors, qualities and Ns to _s_ in place; 85% of bases get a high quality
+static void gd_mutate(const gd_opt_t *opt, int l, char *s, char *q, double err)
+{
+	int i;
+	for (i = 0; i < l; ++i) {
+		int hq = gd_drand() < 0.85;
+		if (gd_drand() < err) s[i] = "ACTG"[((s[i]>>1&3) + gd_irand(1, 3)) & 3]; // A/C/T/G are 0/1/2/3 in (c>>1&3)
+		if (gd_drand() < opt->n_rate) s[i] = 'N';
+		q[i] = 33 + (hq? gd_irand(25, 41) : gd_irand(2, 19));
+	}
+	s[l] = q[l] = 0;
+}
+
+// pick the fragment length (barcodes and transposons included) for an overlap class
+static int gd_frag_len(int cls, int l_read, int l_min)
+{
+	if (cls == GD_FULL) return l_read;
+	if (cls == GD_PARTIAL) return gd_irand(l_read + 1, 2 * l_read - 12);
+	if (cls == GD_CONTAINED) return l_min < l_read? gd_irand(l_min, l_read - 1) : l_read;
+	return gd_irand(2 * l_read, 4 * l_read);
+}
+
+int main(int argc, char *argv[])
+{
+	int c, i, k, n_pairs = 100000, cnt[GD_N_CLASSES], l_frag_max;
+	double w[GD_N_CLASSES] = { 1, 4, 3, 2 }, sum;
+	char *fn[2] = { 0, 0 }, *frag, *rc, *rd[2], *qual[2], line[1024];
+	FILE *fp[2], *fpb;
+	gd_opt_t opt;
+
+	memset(&opt, 0, sizeof(gd_opt_t));
+	opt.l_read = 151, opt.err = 0.03, opt.no_bc = 0.15, opt.n_rate = 0.002;
+	while ((c = getopt(argc, argv, "n:l:s:e:B:N:m:1:2:")) >= 0) {
+		if (c == 'n') n_pairs = atoi(optarg);
+		else if (c == 'l') opt.l_read = atoi(optarg);
+		else if (c == 's') gd_x = strtoull(optarg, 0, 10);
+		else if (c == 'e') opt.err = atof(optarg);
+		else if (c == 'B') opt.no_bc = atof(optarg);
+		else if (c == 'N') opt.n_rate = atof(optarg);
+		else if (c == '1') fn[0] = optarg;
+		else if (c == '2') fn[1] = optarg;
+		else if (c == 'm') {
+			char *p = optarg;
+			for (i = 0; i < GD_N_CLASSES; ++i) {
+				w[i] = strtod(p, &p);
+				if (*p == ',') ++p;
+				else break;
+			}
+			if (i != GD_N_CLASSES - 1 || *p != 0) {
+				fprintf(stderr, "[E::%s] -m expects %d comma-separated weights\n", __func__, GD_N_CLASSES);
+				return 1;
+			}
+		}
+	}
+	if (argc - optind < 1 || (fn[0] == 0) != (fn[1] == 0)) {
+		fprintf(stderr, "Usage: gen-duplex [options] <barcodes.txt>\n");
+		fprintf(stderr, "Options:\n");
+		fprintf(stderr, "  -n INT     number of pairs [%d]\n", n_pairs);
+		fprintf(stderr, "  -l INT     read length [%d]\n", opt.l_read);
+		fprintf(stderr, "  -s INT     random seed [%llu]\n", (unsigned long long)gd_x);
+		fprintf(stderr, "  -e FLOAT   max substitution rate; each pair uses 0, x/15, x/3 or x [%g]\n", opt.err);
+		fprintf(stderr, "  -N FLOAT   rate of N bases [%g]\n", opt.n_rate);
+		fprintf(stderr, "  -B FLOAT   fraction of ends with a random sequence in place of a barcode [%g]\n", opt.no_bc);
+		fprintf(stderr, "  -m STR     weights of full,partial,contained,none overlaps [%g,%g,%g,%g]\n", w[0], w[1], w[2], w[3]);
+		fprintf(stderr, "  -1 FILE    write read 1 to FILE (with -2)\n");
+		fprintf(stderr, "  -2 FILE    write read 2 to FILE; without -1/-2, pairs are interleaved on stdout\n");
+		return 1;
+	}
+
+	if ((fpb = fopen(argv[optind], "r")) == 0) {
+		fprintf(stderr, "[E::%s] failed to open file '%s'\n", __func__, argv[optind]);
+		return 1;
+	}
+	while (fgets(line, sizeof(line), fpb)) {
+		int l;
+		for (l = 0; line[l] == 'A' || line[l] == 'C' || line[l] == 'G' || line[l] == 'T'; ++l);
+		if (l == 0 || l >= 64) continue;
+		line[l] = 0;
+		opt.bc = (char**)realloc(opt.bc, (opt.n_bc + 1) * sizeof(char*));
+		opt.bc[opt.n_bc++] = strdup(line);
+	}
+	fclose(fpb);
+	if (opt.n_bc == 0) {
+		fprintf(stderr, "[E::%s] no barcodes in '%s'\n", __func__, argv[optind]);
+		return 1;
+	}
+	if (opt.l_read < 100) {
+		fprintf(stderr, "[E::%s] reads shorter than 100bp cannot hold both barcodes and transposons\n", __func__);
+		return 1;
+	}
+	for (i = 0, sum = 0.0; i < GD_N_CLASSES; ++i) sum += w[i];
+	for (i = 0; i < GD_N_CLASSES; ++i)
+		opt.mix[i] = (i? opt.mix[i-1] : 0.0) + w[i] / sum;
+
+	if (fn[0]) {
+		for (k = 0; k < 2; ++k)
+			if ((fp[k] = fopen(fn[k], "w")) == 0) {
+				fprintf(stderr, "[E::%s] failed to open file '%s' for writing\n", __func__, fn[k]);
+				return 1;
+			}
+	} else fp[0] = fp[1] = stdout;
+
+	l_frag_max = 4 * opt.l_read + 1;
+	frag = (char*)malloc(l_frag_max);
+	rc = (char*)malloc(l_frag_max);
+	for (k = 0; k < 2; ++k) {
+		rd[k] = (char*)malloc(opt.l_read + 1);
+		qual[k] = (char*)malloc(opt.l_read + 1);
+	}
+	memset(cnt, 0, sizeof(cnt));
+	for (i = 0; i < n_pairs; ++i) {
+		int cls, l_frag, l_ins, n = 0, l_bc[2], l_oligo = strlen(gd_oligo);
+		char bc[2][64];
+		double u = gd_drand(), err;
+		for (cls = 0; cls < GD_N_CLASSES - 1 && u >= opt.mix[cls]; ++cls);
+		++cnt[cls];
+		for (k = 0; k < 2; ++k) {
+			if (gd_drand() < opt.no_bc) {
+				l_bc[k] = 12;
+				gd_random_seq(l_bc[k], bc[k]);
+			} else {
+				const char *b = opt.bc[gd_rand() % opt.n_bc];
+				l_bc[k] = strlen(b);
+				memcpy(bc[k], b, l_bc[k]);
+			}
+		}
+		l_frag = gd_frag_len(cls, opt.l_read, l_bc[0] + l_bc[1] + 2 * l_oligo + 20);
+		l_ins = l_frag - l_bc[0] - l_bc[1] - 2 * l_oligo;
+		gd_cat(frag, &n, l_bc[0], bc[0]);
+		gd_cat(frag, &n, l_oligo, gd_oligo);
+		gd_random_seq(l_ins, frag + n), n += l_ins;
+		gd_revcomp(l_oligo, gd_oligo, frag + n), n += l_oligo;
+		gd_revcomp(l_bc[1], bc[1], frag + n), n += l_bc[1];
+		gd_revcomp(l_frag, frag, rc);
+		u = gd_drand(), err = u < 0.25? 0.0 : u < 0.5? opt.err / 15 : u < 0.75? opt.err / 3 : opt.err;
+		for (k = 0; k < 2; ++k) { // fragment, then adapter, then random bases
+			const char *src = k == 0? frag : rc, *adap = gd_adapter[k];
+			int l_adap = strlen(adap), m = 0, l;
+			l = l_frag < opt.l_read? l_frag : opt.l_read;
+			gd_cat(rd[k], &m, l, src);
+			l = opt.l_read - m < l_adap? opt.l_read - m : l_adap;
+			gd_cat(rd[k], &m, l, adap);
+			gd_random_seq(opt.l_read - m, rd[k] + m);
+			gd_mutate(&opt, opt.l_read, rd[k], qual[k], err);
+		}
+		if (gd_drand() < 0.05) memset(rd[0], 'N', gd_irand(1, 5)); // leading Ns on read 1
+		if (gd_drand() < 0.05) memset(rd[1] + opt.l_read - 4, 'N', 4); // trailing Ns on read 2
+		for (k = 0; k < 2; ++k)
+			fprintf(fp[k], "@gd%d %d:N:0:%s\n%s\n+\n%s\n", i, k + 1, gd_class_str[cls], rd[k], qual[k]);
+	}
+	for (k = 0; k < 2; ++k) {
+		free(rd[k]); free(qual[k]);
+	}
+	free(frag); free(rc);
+	for (i = 0; i < opt.n_bc; ++i) free(opt.bc[i]);
+	free(opt.bc);
+	fprintf(stderr, "[M::%s] simulated %d pairs:", __func__, n_pairs);
+	for (i = 0; i < GD_N_CLASSES; ++i)
+		fprintf(stderr, " %d %s%s", cnt[i], gd_class_str[i], i == GD_N_CLASSES - 1? "" : ",");
+	fprintf(stderr, "\n");
+	if (fn[0]) {
+		if (fclose(fp[0]) != 0 || fclose(fp[1]) != 0) {
+			fprintf(stderr, "[E::%s] failed to write the output\n", __func__);
+			return 1;
+		}
+	}
+	return 0;
+}
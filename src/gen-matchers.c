@@ -0,0 +1,186 @@
+/* Generate matchers specialized for the chemistry in chemistry.h, for preprocess. The output is C code with the
+	barcode automaton built by lt_bcidx_init() as constant tables, and the adapter matchers of lt_ue_for_bp()
+	unrolled over the adapter bases, so that the compiler folds the bases and thresholds into the code. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <ctype.h>
+#include "chemistry.h"
+
+static int gm_nt4(int c) { return c == 'A'? 0 : c == 'C'? 1 : c == 'G'? 2 : c == 'T'? 3 : 4; }
+
+static inline const char *gm_sep(int i, int per_line) { return i == 0? "\n\t" : i % per_line? ", " : ",\n\t"; }
+
+typedef struct {
+	int n, n_nodes, max_out;
+	int *len;
+	char **seq;
+	int32_t (*next)[4];
+	int32_t *out, *olink;
+} gm_bcidx_t;
+
+// the same construction as lt_bcidx_init() in preprocess.c, so that node numbers and barcode ids agree
+static gm_bcidx_t *gm_bcidx_init(int n, char **seq)
+{
+	gm_bcidx_t *bi;
+	int i, j, c, m, *q, qh, qt;
+	bi = (gm_bcidx_t*)calloc(1, sizeof(gm_bcidx_t));
+	bi->len = (int*)calloc(n, sizeof(int));
+	bi->seq = (char**)calloc(n, sizeof(char*));
+	for (i = m = 0; i < n; ++i) {
+		for (j = 0; j < bi->n; ++j)
+			if (strcmp(bi->seq[j], seq[i]) == 0) break;
+		if (j < bi->n) continue; // a duplicate
+		for (j = 0; seq[i][j]; ++j)
+			if (gm_nt4(seq[i][j]) > 3) break;
+		if (seq[i][j] || j == 0) {
+			fprintf(stderr, "[E::%s] barcode '%s' is empty or not made of A/C/G/T\n", __func__, seq[i]);
+			return 0;
+		}
+		bi->len[bi->n] = j, bi->seq[bi->n++] = seq[i];
+		m += j;
+	}
+	bi->next = (int32_t(*)[4])malloc((m + 1) * sizeof(*bi->next));
+	bi->out = (int32_t*)malloc((m + 1) * sizeof(int32_t));
+	bi->olink = (int32_t*)calloc(m + 1, sizeof(int32_t));
+	memset(bi->next, 0xff, (m + 1) * sizeof(*bi->next));
+	bi->n_nodes = 1, bi->out[0] = -1;
+	for (i = 0; i < bi->n; ++i) {
+		int v = 0;
+		for (j = 0; j < bi->len[i]; ++j) {
+			c = gm_nt4(bi->seq[i][j]);
+			if (bi->next[v][c] < 0)
+				bi->out[bi->n_nodes] = -1, bi->next[v][c] = bi->n_nodes++;
+			v = bi->next[v][c];
+		}
+		bi->out[v] = i;
+	}
+	q = (int*)malloc(bi->n_nodes * 2 * sizeof(int));
+	qh = qt = 0;
+	for (c = 0; c < 4; ++c) {
+		if (bi->next[0][c] < 0) bi->next[0][c] = 0;
+		else q[qt++] = bi->next[0][c], q[qt++] = 0;
+	}
+	while (qh < qt) {
+		int v = q[qh++], f = q[qh++];
+		bi->olink[v] = bi->out[f] >= 0? f : bi->olink[f];
+		for (c = 0; c < 4; ++c) {
+			int u = bi->next[v][c];
+			if (u < 0) bi->next[v][c] = bi->next[f][c];
+			else q[qt++] = u, q[qt++] = bi->next[f][c];
+		}
+	}
+	free(q);
+	for (i = 1; i < bi->n_nodes; ++i) {
+		int v, k = 0;
+		for (v = bi->out[i] >= 0? i : bi->olink[i]; v > 0; v = bi->olink[v]) ++k;
+		bi->max_out = bi->max_out > k? bi->max_out : k;
+	}
+	return bi;
+}
+
+// load barcodes as lt_bcidx_load() does: one per line, with a "FWD-REV" pair split into two barcodes
+static int gm_bc_load(const char *fn, char ***a)
+{
+	FILE *fp;
+	char line[1024], *p, *q;
+	int n = 0, m = 0;
+	if ((fp = fopen(fn, "r")) == 0) return -1;
+	*a = 0;
+	while (fgets(line, sizeof(line), fp)) {
+		for (p = line; *p && !isspace((uint8_t)*p); ++p);
+		*p = 0;
+		for (p = line; *p; p = *q? q + 1 : q) {
+			for (q = p; *q && *q != '-'; ++q);
+			if (n == m) {
+				m = m? m<<1 : 16;
+				*a = (char**)realloc(*a, m * sizeof(char*));
+			}
+			(*a)[n++] = strndup(p, q - p);
+		}
+	}
+	fclose(fp);
+	return n;
+}
+
+static void gm_print_i32(const char *name, int n, const int32_t *a)
+{
+	int i;
+	printf("static const int32_t %s[%d] = {", name, n);
+	for (i = 0; i < n; ++i) printf("%s%d", gm_sep(i, 24), a[i]);
+	printf("\n};\n");
+}
+
+static void gm_print_bc(const gm_bcidx_t *bi)
+{
+	int i;
+	printf("// Aho-Corasick automaton over the barcodes, numbered as by lt_bcidx_init()\n");
+	printf("#define LT_GEN_BC_N %d\n#define LT_GEN_BC_NODES %d\n#define LT_GEN_BC_MAX_OUT %d\n", bi->n, bi->n_nodes, bi->max_out);
+	printf("static const char *lt_gen_bc_seq[LT_GEN_BC_N] = {");
+	for (i = 0; i < bi->n; ++i) printf("%s\"%s\"", gm_sep(i, 6), bi->seq[i]);
+	printf("\n};\n");
+	printf("static const int lt_gen_bc_len[LT_GEN_BC_N] = {");
+	for (i = 0; i < bi->n; ++i) printf("%s%d", gm_sep(i, 24), bi->len[i]);
+	printf("\n};\n");
+	printf("static const int32_t lt_gen_bc_next[LT_GEN_BC_NODES][4] = {");
+	for (i = 0; i < bi->n_nodes; ++i)
+		printf("%s{%d,%d,%d,%d}", gm_sep(i, 8), bi->next[i][0], bi->next[i][1], bi->next[i][2], bi->next[i][3]);
+	printf("\n};\n");
+	gm_print_i32("lt_gen_bc_out", bi->n_nodes, bi->out);
+	gm_print_i32("lt_gen_bc_olink", bi->n_nodes, bi->olink);
+}
+
+// lt_ue_for_bp() for adapter _k_, with one lt_bp_col() per adapter base and the thresholds of lt_ue_for1()
+static int gm_print_adap(int k, const char *adap, int max_pen, int min_len)
+{
+	int j, l = strlen(adap), t_max;
+	for (j = 0; j < l; ++j)
+		if (gm_nt4(adap[j]) > 3) {
+			fprintf(stderr, "[E::%s] adapter '%s' is not made of A/C/G/T\n", __func__, adap);
+			return -1;
+		}
+	t_max = (l - 1) * max_pen / min_len > max_pen? (l - 1) * max_pen / min_len : max_pen;
+	printf("\n#define LT_GEN_ADAP%d \"%s\"\n", k, adap);
+	printf("#define LT_GEN_ADAP%d_PLANES (32 - __builtin_clz(%d + LT_HIGH_PEN))\n\n", k, t_max);
+	printf("static int lt_gen_adap%d_for(int l1, const char *s1, const char *q1, int max_pos, uint64_t *pos)\n{\n", k);
+	printf("\tlt_bp_t b;\n\tif (l1 < %d) return 0;\n", min_len);
+	printf("\tlt_bp_init(&b, l1, s1, q1, %d, LT_GEN_ADAP%d_PLANES, alloca(lt_bp_size(l1, LT_GEN_ADAP%d_PLANES)));\n", min_len, k, k);
+	for (j = 0; j < l; ++j) {
+		int t = j * max_pen / min_len > max_pen? j * max_pen / min_len : max_pen;
+		printf("\t%slt_bp_col(&b, l1, LT_GEN_ADAP%d_PLANES, %d, %d, %d)%s\n", j? "\t&& " : "(void)(", k, j, gm_nt4(adap[j]), t, j == l - 1? ");" : "");
+	}
+	printf("\treturn lt_bp_report(&b, l1, %d, max_pos, pos);\n}\n", l);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int n;
+	char **bc;
+	gm_bcidx_t *bi;
+
+	if (argc > 1 && strcmp(argv[1], "-h") == 0) {
+		fprintf(stderr, "Usage: gen-matchers [barcodes.txt] > matchers.h\n");
+		fprintf(stderr, "Note: without a barcode file, the built-in Tn5 barcodes of chemistry.h are used\n");
+		return 1;
+	}
+	if (argc > 1) {
+		if ((n = gm_bc_load(argv[1], &bc)) <= 0) {
+			fprintf(stderr, "[E::%s] failed to load barcodes from '%s'\n", __func__, argv[1]);
+			return 1;
+		}
+	} else {
+		for (n = 0; Tn5_barcode[n]; ++n);
+		bc = (char**)Tn5_barcode;
+	}
+	if ((bi = gm_bcidx_init(n, bc)) == 0) return 1;
+
+	printf("/* Generated by gen-matchers from %s; do not edit. */\n\n", argc > 1? argv[1] : "chemistry.h");
+	printf("#define LT_GEN_ADAP_PEN %d\n#define LT_GEN_ADAP_MIN_LEN %d\n\n", LT_ADAP_PEN, LT_ADAP_MIN_LEN);
+	gm_print_bc(bi);
+	if (gm_print_adap(1, lt_adapter1, LT_ADAP_PEN, LT_ADAP_MIN_LEN) < 0) return 1;
+	if (gm_print_adap(2, lt_adapter2, LT_ADAP_PEN, LT_ADAP_MIN_LEN) < 0) return 1;
+	return 0;
+}
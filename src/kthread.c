@@ -5,6 +5,7 @@
 #include <pthread.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <time.h>
 
 /************
  * kt_for() *
@@ -71,38 +72,50 @@ struct ktp_t;
 
 typedef struct {
 	struct ktp_t *pl;
-	int step, running;
+	long index; // order of the data this worker is carrying
+	int step;
 	void *data;
 } ktp_worker_t;
 
 typedef struct ktp_t {
 	void *shared;
 	void *(*func)(void*, int, void*);
+	long index;
 	int n_workers, n_steps;
+	double *wait; // if not NULL, wait[i] accumulates the seconds workers are blocked before step i
 	ktp_worker_t *workers;
 	pthread_mutex_t mutex;
 	pthread_cond_t cv;
 } ktp_t;
 
+static inline double ktp_realtime(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
 static void *ktp_worker(void *data)
 {
 	ktp_worker_t *w = (ktp_worker_t*)data;
 	ktp_t *p = w->pl;
 	while (w->step < p->n_steps) {
 		// test whether we can kick off the job with this worker
+		double t = 0.0;
 		pthread_mutex_lock(&p->mutex);
 		for (;;) {
 			int i;
-			// test whether another worker is doing the same step
+			// test whether a worker carrying earlier data has not finished w->step yet
 			for (i = 0; i < p->n_workers; ++i) {
 				if (w == &p->workers[i]) continue; // ignore itself
-				if (p->workers[i].running && p->workers[i].step == w->step)
+				if (p->workers[i].step <= w->step && p->workers[i].index < w->index)
 					break;
 			}
-			if (i == p->n_workers) break; // no other workers doing w->step; then this worker will
+			if (i == p->n_workers) break; // data are processed in order at each step
+			if (p->wait && t == 0.0) t = ktp_realtime();
 			pthread_cond_wait(&p->cv, &p->mutex);
 		}
-		w->running = 1;
+		if (t > 0.0) p->wait[w->step] += ktp_realtime() - t;
 		pthread_mutex_unlock(&p->mutex);
 
 		// working on w->step
@@ -111,14 +124,14 @@ static void *ktp_worker(void *data)
 		// update step and let other workers know
 		pthread_mutex_lock(&p->mutex);
 		w->step = w->step == p->n_steps - 1 || w->data? (w->step + 1) % p->n_steps : p->n_steps;
-		w->running = 0;
+		if (w->step == 0) w->index = p->index++; // pick up the next piece of data
 		pthread_cond_broadcast(&p->cv);
 		pthread_mutex_unlock(&p->mutex);
 	}
 	pthread_exit(0);
 }
 
-void kt_pipeline(int n_threads, void *(*func)(void*, int, void*), void *shared_data, int n_steps)
+void kt_pipeline_timed(int n_threads, void *(*func)(void*, int, void*), void *shared_data, int n_steps, double *wait)
 {
 	ktp_t aux;
 	pthread_t *tid;
@@ -129,13 +142,16 @@ void kt_pipeline(int n_threads, void *(*func)(void*, int, void*), void *shared_d
 	aux.n_steps = n_steps;
 	aux.func = func;
 	aux.shared = shared_data;
+	aux.wait = wait;
 	pthread_mutex_init(&aux.mutex, 0);
 	pthread_cond_init(&aux.cv, 0);
 
+	aux.index = 0;
 	aux.workers = alloca(n_threads * sizeof(ktp_worker_t));
 	for (i = 0; i < n_threads; ++i) {
 		ktp_worker_t *w = &aux.workers[i];
-		w->step = w->running = 0; w->pl = &aux; w->data = 0;
+		w->step = 0; w->pl = &aux; w->data = 0;
+		w->index = aux.index++;
 	}
 
 	tid = alloca(n_threads * sizeof(pthread_t));
@@ -145,3 +161,8 @@ void kt_pipeline(int n_threads, void *(*func)(void*, int, void*), void *shared_d
 	pthread_mutex_destroy(&aux.mutex);
 	pthread_cond_destroy(&aux.cv);
 }
+
+void kt_pipeline(int n_threads, void *(*func)(void*, int, void*), void *shared_data, int n_steps)
+{
+	kt_pipeline_timed(n_threads, func, shared_data, n_steps, 0);
+}
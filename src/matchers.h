@@ -0,0 +1,175 @@
+/* Generated by gen-matchers from chemistry.h; do not edit. */
+
+#define LT_GEN_ADAP_PEN 1
+#define LT_GEN_ADAP_MIN_LEN 3
+
+// Aho-Corasick automaton over the barcodes, numbered as by lt_bcidx_init()
+#define LT_GEN_BC_N 16
+#define LT_GEN_BC_NODES 170
+#define LT_GEN_BC_MAX_OUT 1
+static const char *lt_gen_bc_seq[LT_GEN_BC_N] = {
+	"GGCACCGAAAA", "CTCGGCGATAAA", "GGTGGAGCATAA", "CGAGCGCATTAA", "AGCCCGGTTATA", "TCGGCACCAATA",
+	"GCCTGTGGATTA", "GCGACCCTTTTA", "GCATGCGGTAAT", "GCGTTGCCATAT", "GGCCGCATTTAT", "ACCGCCTCTATT",
+	"CCGTGCCAAAAT", "TCTCCGGGAATT", "CCGCGCTTATTT", "CTGAGCTCGTTTT"
+};
+static const int lt_gen_bc_len[LT_GEN_BC_N] = {
+	11, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 13
+};
+static const int32_t lt_gen_bc_next[LT_GEN_BC_NODES][4] = {
+	{45,12,1,57}, {45,69,2,57}, {45,3,2,24}, {4,109,80,13}, {45,5,46,91}, {45,6,34,13}, {45,129,7,13}, {8,121,2,131},
+	{9,118,36,57}, {10,118,46,57}, {11,118,46,57}, {45,118,46,57}, {45,129,34,13}, {45,14,159,57}, {45,129,15,140}, {35,69,16,57},
+	{45,17,2,24}, {62,109,18,13}, {19,69,2,100}, {45,82,36,20}, {21,58,1,57}, {22,118,46,57}, {23,118,46,57}, {45,118,46,57},
+	{45,58,25,57}, {45,69,26,57}, {27,3,2,24}, {45,118,28,57}, {45,29,2,57}, {30,48,80,13}, {45,118,46,31}, {32,58,92,57},
+	{33,118,46,57}, {45,118,46,57}, {35,69,2,57}, {45,118,36,57}, {45,37,2,57}, {90,48,38,13}, {81,39,2,100}, {40,70,80,13},
+	{45,118,46,41}, {45,58,92,42}, {43,58,1,57}, {44,118,46,57}, {45,118,46,57}, {45,118,46,57}, {45,47,2,57}, {90,48,80,13},
+	{45,49,130,71}, {45,129,50,13}, {35,150,51,131}, {45,3,2,52}, {45,58,25,53}, {54,58,1,57}, {45,118,46,55}, {56,58,1,57},
+	{45,118,46,57}, {45,58,1,57}, {45,129,59,140}, {35,69,60,57}, {45,61,2,24}, {62,109,80,13}, {45,63,46,91}, {45,64,34,13},
+	{65,129,7,13}, {66,118,46,57}, {45,118,46,67}, {68,58,1,57}, {45,118,46,57}, {90,70,80,13}, {45,129,130,71}, {45,14,72,57},
+	{160,69,2,73}, {45,58,74,57}, {45,69,75,57}, {76,3,2,24}, {45,118,46,77}, {45,58,1,78}, {79,58,1,57}, {45,118,46,57},
+	{81,69,2,100}, {45,82,36,57}, {45,83,34,13}, {45,84,120,13}, {45,129,130,85}, {45,14,159,86}, {45,58,1,87}, {45,58,1,88},
+	{89,58,1,57}, {45,118,46,57}, {45,118,46,91}, {45,58,92,57}, {45,93,2,57}, {90,70,94,13}, {81,69,95,100}, {45,3,2,96},
+	{97,58,25,57}, {98,118,46,57}, {45,118,46,99}, {45,58,1,57}, {45,58,1,101}, {45,58,102,57}, {45,103,2,57}, {90,104,80,13},
+	{105,129,130,71}, {45,118,46,106}, {107,58,1,57}, {45,118,46,108}, {45,58,1,57}, {45,129,110,71}, {35,111,2,131}, {112,70,151,13},
+	{45,118,46,113}, {45,58,92,114}, {45,58,1,115}, {116,58,1,57}, {45,118,46,117}, {45,58,1,57}, {45,119,34,13}, {45,129,120,13},
+	{35,121,2,131}, {90,122,151,13}, {45,129,130,123}, {45,124,72,57}, {45,129,15,125}, {126,141,159,57}, {45,118,46,127}, {45,58,1,128},
+	{45,58,1,57}, {45,129,130,13}, {35,150,2,131}, {45,58,132,57}, {45,133,2,57}, {90,134,80,13}, {135,129,130,71}, {136,118,46,57},
+	{137,118,46,57}, {138,118,46,57}, {45,118,46,139}, {45,58,1,57}, {45,141,159,57}, {45,142,15,140}, {45,129,143,13}, {35,150,144,131},
+	{45,3,145,24}, {146,3,2,24}, {147,118,46,57}, {45,118,46,148}, {45,58,1,149}, {45,58,1,57}, {90,70,151,13}, {81,152,2,100},
+	{90,70,80,153}, {45,14,159,154}, {155,58,1,57}, {45,118,46,156}, {45,58,1,157}, {45,58,1,158}, {45,58,1,57}, {160,69,2,57},
+	{45,118,161,57}, {45,162,2,57}, {90,48,80,163}, {45,164,159,57}, {45,129,165,140}, {35,69,16,166}, {45,58,1,167}, {45,58,1,168},
+	{45,58,1,169}, {45,58,1,57}
+};
+static const int32_t lt_gen_bc_out[170] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 3, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 5, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, 7, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, 8, -1, -1, -1, -1, -1, -1, -1, -1, 9, -1, -1, -1, -1, -1, -1, -1, -1, 10, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 12, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, 13, -1, -1, -1, -1, -1, -1, -1, -1, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, 15
+};
+static const int32_t lt_gen_bc_olink[170] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0
+};
+
+#define LT_GEN_ADAP1 "AGATCGGAAGAGCACACGTCTGAACTCCAGTCAC"
+#define LT_GEN_ADAP1_PLANES (32 - __builtin_clz(11 + LT_HIGH_PEN))
+
+static int lt_gen_adap1_for(int l1, const char *s1, const char *q1, int max_pos, uint64_t *pos)
+{
+	lt_bp_t b;
+	if (l1 < 3) return 0;
+	lt_bp_init(&b, l1, s1, q1, 3, LT_GEN_ADAP1_PLANES, alloca(lt_bp_size(l1, LT_GEN_ADAP1_PLANES)));
+	(void)(lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 0, 0, 1)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 1, 2, 1)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 2, 0, 1)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 3, 3, 1)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 4, 1, 1)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 5, 2, 1)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 6, 2, 2)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 7, 0, 2)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 8, 0, 2)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 9, 2, 3)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 10, 0, 3)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 11, 2, 3)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 12, 1, 4)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 13, 0, 4)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 14, 1, 4)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 15, 0, 5)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 16, 1, 5)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 17, 2, 5)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 18, 3, 6)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 19, 1, 6)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 20, 3, 6)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 21, 2, 7)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 22, 0, 7)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 23, 0, 7)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 24, 1, 8)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 25, 3, 8)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 26, 1, 8)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 27, 1, 9)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 28, 0, 9)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 29, 2, 9)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 30, 3, 10)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 31, 1, 10)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 32, 0, 10)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP1_PLANES, 33, 1, 11));
+	return lt_bp_report(&b, l1, 34, max_pos, pos);
+}
+
+#define LT_GEN_ADAP2 "AGATCGGAAGAGCGTCGTGTAGGGAAAGAGTGTAGATCTCGGTGGTCGCCGTATCATT"
+#define LT_GEN_ADAP2_PLANES (32 - __builtin_clz(19 + LT_HIGH_PEN))
+
+static int lt_gen_adap2_for(int l1, const char *s1, const char *q1, int max_pos, uint64_t *pos)
+{
+	lt_bp_t b;
+	if (l1 < 3) return 0;
+	lt_bp_init(&b, l1, s1, q1, 3, LT_GEN_ADAP2_PLANES, alloca(lt_bp_size(l1, LT_GEN_ADAP2_PLANES)));
+	(void)(lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 0, 0, 1)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 1, 2, 1)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 2, 0, 1)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 3, 3, 1)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 4, 1, 1)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 5, 2, 1)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 6, 2, 2)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 7, 0, 2)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 8, 0, 2)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 9, 2, 3)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 10, 0, 3)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 11, 2, 3)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 12, 1, 4)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 13, 2, 4)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 14, 3, 4)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 15, 1, 5)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 16, 2, 5)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 17, 3, 5)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 18, 2, 6)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 19, 3, 6)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 20, 0, 6)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 21, 2, 7)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 22, 2, 7)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 23, 2, 7)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 24, 0, 8)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 25, 0, 8)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 26, 0, 8)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 27, 2, 9)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 28, 0, 9)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 29, 2, 9)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 30, 3, 10)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 31, 2, 10)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 32, 3, 10)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 33, 0, 11)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 34, 2, 11)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 35, 0, 11)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 36, 3, 12)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 37, 1, 12)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 38, 3, 12)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 39, 1, 13)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 40, 2, 13)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 41, 2, 13)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 42, 3, 14)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 43, 2, 14)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 44, 2, 14)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 45, 3, 15)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 46, 1, 15)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 47, 2, 15)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 48, 1, 16)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 49, 1, 16)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 50, 2, 16)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 51, 3, 17)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 52, 0, 17)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 53, 3, 17)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 54, 1, 18)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 55, 0, 18)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 56, 3, 18)
+		&& lt_bp_col(&b, l1, LT_GEN_ADAP2_PLANES, 57, 3, 19));
+	return lt_bp_report(&b, l1, 58, max_pos, pos);
+}
@@ -10,37 +10,13 @@
 #include <ctype.h>
 #include <stdio.h>
 #include "kvec.h"
+#include "kstring.h"
 
 /********************
  * Global variables *
  ********************/
 
-const char *lt_adapter1 = "AGATCGGAAGAGCACACGTCTGAACTCCAGTCAC"; // Illumina 3'-end adapter
-const char *lt_adapter2 = "AGATCGGAAGAGCGTCGTGTAGGGAAAGAGTGTAGATCTCGGTGGTCGCCGTATCATT";
-const char *lt_oligo_for= "AGATGTGTATAAGAGACAG"; // 19bp transposon
-const char *lt_oligo_rev= "CTGTCTCTTATACACATCT";
-
-//By Bowen Jin
-const char *Tn5_barcode[] = {
-"GGCACCGAAAA",
-"CTCGGCGATAAA",
-"GGTGGAGCATAA",
-"CGAGCGCATTAA",
-"AGCCCGGTTATA",
-"TCGGCACCAATA",
-"GCCTGTGGATTA",
-"GCGACCCTTTTA",
-"GCATGCGGTAAT",
-"GCGTTGCCATAT",
-"GGCCGCATTTAT",
-"ACCGCCTCTATT",
-"CCGTGCCAAAAT",
-"TCTCCGGGAATT",
-"CCGCGCTTATTT",
-"CTGAGCTCGTTTT",
-0
-};
-//
+#include "chemistry.h"
 
 enum lt_type_e {
 	LT_UNKNOWN = 0,
@@ -68,19 +44,32 @@ typedef struct {
 	int tab_out;
 	int bc_cut;
 	int qmask;
+	int inflate;
+	int merge_exact;
+	int no_merge;
+	int n_inflight; // number of chunks in the pipeline
+	int stats_every; // write --stats every this many chunks; 0 for only at the end
+	int ckpt_every; // write --checkpoint every this many chunks
+	int bc_rescue; // max Hamming distance for barcode rescue; 0 to disable
+	int batch; // trim N and adapters with the batch engine
+	int require_bc; // drop pairs without a barcode at both 5'-ends before merging
 } lt_opt_t;
 
+int lt_verbose = 3;
+
 static void lt_opt_init(lt_opt_t *opt)
 {
 	memset(opt, 0, sizeof(lt_opt_t));
 	opt->n_threads = 2;
 	opt->chunk_size = 10000000;
+	opt->n_inflight = 3;
+	opt->ckpt_every = 16;
 	opt->max_qual = 50;
 	opt->min_seq_len = 40;
 	opt->max_ovlp_pen = 2;
 	opt->min_ovlp_len = 8;
-	opt->max_adap_pen = 1;
-	opt->min_adap_len = 3;
+	opt->max_adap_pen = LT_ADAP_PEN;
+	opt->min_adap_len = LT_ADAP_MIN_LEN;
 	opt->max_olig_pen = 2;
 	opt->min_olig_len = 10; // total length = 19
 	opt->bc_cut = 1;
@@ -126,32 +115,180 @@ void lt_seq_revcomp(int l, const char *f, char *r)
 #define LT_HIGH_PEN 3
 #define LT_LOW_PEN  1
 
-int lt_ue_for1(int l1, const char *s1, const char *q1, int l2, const char *s2, const char *q2, int min_len, int max_pen)
+#define LT_UE_HEAD 16 // extend this many bases in scalar before switching to SIMD
+
+#define lt_ue_stop(pen, i, min_len, max_pen) ((i) <= (min_len)? (pen) > (max_pen) : (pen) * (min_len) > (i) * (max_pen)) // in effect: pen > max_pen * ((double)i / min_len)
+
+int lt_simd = 0; // 0 for scalar, 1 for SSE2 and 2 for AVX2; set by lt_simd_init()
+
+// the scalar kernels: extend from offset i up to n with penalty *pen; return n if not stopped earlier
+static inline int lt_ue_for1_s(int i, int n, int *pen, const char *s1, const char *q1, const char *s2, const char *q2, int min_len, int max_pen)
 {
-	int i, pen = 0;
-	for (i = 0; i < l1 && i < l2; ++i) {
+	for (; i < n; ++i) {
 		if (s1[i] != s2[i]) {
-			pen += q1[i] >= LT_QUAL_THRES && (q2 == 0 || q2[i] >= LT_QUAL_THRES)? LT_HIGH_PEN : LT_LOW_PEN;
-			if (i <= min_len && pen > max_pen) break;
-			if (i > min_len && pen * min_len > i * max_pen) break; // in effect: pen > max_pen * ((double)i / min_len)
+			*pen += q1[i] >= LT_QUAL_THRES && (q2 == 0 || q2[i] >= LT_QUAL_THRES)? LT_HIGH_PEN : LT_LOW_PEN;
+			if (lt_ue_stop(*pen, i, min_len, max_pen)) break;
 		}
 	}
 	return i;
 }
 
-int lt_ue_rev1(int l1, const char *s1, const char *q1, int l2, const char *s2, const char *q2, int min_len, int max_pen)
+static inline int lt_ue_rev1_s(int i, int n, int *pen, int l1, const char *s1, const char *q1, int l2, const char *s2, const char *q2, int min_len, int max_pen)
 {
-	int i, pen = 0;
-	for (i = 0; i < l1 && i < l2; ++i) {
+	for (; i < n; ++i) {
 		if (s1[l1-1-i] != s2[l2-1-i]) {
-			pen += q1[l1-1-i] >= LT_QUAL_THRES && (q2 == 0 || q2[l2-1-i] >= LT_QUAL_THRES)? LT_HIGH_PEN : LT_LOW_PEN;
-			if (i <= min_len && pen > max_pen) break;
-			if (i > min_len && pen * min_len > i * max_pen) break;
+			*pen += q1[l1-1-i] >= LT_QUAL_THRES && (q2 == 0 || q2[l2-1-i] >= LT_QUAL_THRES)? LT_HIGH_PEN : LT_LOW_PEN;
+			if (lt_ue_stop(*pen, i, min_len, max_pen)) break;
 		}
 	}
 	return i;
 }
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+
+/* The vectorized kernels compare 16 or 32 bases at a time. Matching blocks are skipped with one test; for
+ * a block with mismatches, we walk the set bits of the mismatch mask in the order the scalar loop would
+ * visit them, taking the penalty from a bitmask of high-quality positions. Most calls come from the
+ * barcode/oligo scans and stop within a few bases, so lt_ue_for1() and lt_ue_rev1() only enter these
+ * kernels after the first LT_UE_HEAD bases have been extended in scalar. */
+
+#define LT_UE_WALK_FOR(mm, hq, base) do { \
+		int j = __builtin_ctz(mm), k = (base) + j; \
+		pen += (hq)>>j&1? LT_HIGH_PEN : LT_LOW_PEN; \
+		if (lt_ue_stop(pen, k, min_len, max_pen)) return k; \
+		(mm) &= (mm) - 1; \
+	} while (mm)
+
+#define LT_UE_WALK_REV(mm, hq, base, w) do { \
+		int j = 31 - __builtin_clz(mm), k = (base) + (w) - 1 - j; \
+		pen += (hq)>>j&1? LT_HIGH_PEN : LT_LOW_PEN; \
+		if (lt_ue_stop(pen, k, min_len, max_pen)) return k; \
+		(mm) &= ~(1U << j); \
+	} while (mm)
+
+static inline uint32_t lt_hq_mask16(const char *q1, const char *q2)
+{
+	const __m128i t = _mm_set1_epi8(LT_QUAL_THRES - 1);
+	uint32_t hq = _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*)q1), t));
+	if (q2) hq &= _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*)q2), t));
+	return hq;
+}
+
+static inline uint32_t lt_neq_mask16(const char *s1, const char *s2)
+{
+	return ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)s1), _mm_loadu_si128((const __m128i*)s2))) & 0xffff;
+}
+
+static int lt_ue_for1_sse2(int i, int n, int pen, int l1, const char *s1, const char *q1, int l2, const char *s2, const char *q2, int min_len, int max_pen)
+{
+	for (; i + 16 <= n; i += 16) {
+		uint32_t mm = lt_neq_mask16(s1 + i, s2 + i), hq;
+		if (mm == 0) continue;
+		hq = lt_hq_mask16(q1 + i, q2? q2 + i : 0);
+		LT_UE_WALK_FOR(mm, hq, i);
+	}
+	return lt_ue_for1_s(i, n, &pen, s1, q1, s2, q2, min_len, max_pen);
+}
+
+static int lt_ue_rev1_sse2(int i, int n, int pen, int l1, const char *s1, const char *q1, int l2, const char *s2, const char *q2, int min_len, int max_pen)
+{
+	for (; i + 16 <= n; i += 16) {
+		int o1 = l1 - i - 16, o2 = l2 - i - 16;
+		uint32_t mm = lt_neq_mask16(s1 + o1, s2 + o2), hq;
+		if (mm == 0) continue;
+		hq = lt_hq_mask16(q1 + o1, q2? q2 + o2 : 0);
+		LT_UE_WALK_REV(mm, hq, i, 16);
+	}
+	return lt_ue_rev1_s(i, n, &pen, l1, s1, q1, l2, s2, q2, min_len, max_pen);
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t lt_hq_mask32(const char *q1, const char *q2)
+{
+	const __m256i t = _mm256_set1_epi8(LT_QUAL_THRES - 1);
+	uint32_t hq = _mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_loadu_si256((const __m256i*)q1), t));
+	if (q2) hq &= _mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_loadu_si256((const __m256i*)q2), t));
+	return hq;
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t lt_neq_mask32(const char *s1, const char *s2)
+{
+	return ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)s1), _mm256_loadu_si256((const __m256i*)s2)));
+}
+
+__attribute__((target("avx2")))
+static int lt_ue_for1_avx2(int i, int n, int pen, int l1, const char *s1, const char *q1, int l2, const char *s2, const char *q2, int min_len, int max_pen)
+{
+	for (; i + 32 <= n; i += 32) {
+		uint32_t mm = lt_neq_mask32(s1 + i, s2 + i), hq;
+		if (mm == 0) continue;
+		hq = lt_hq_mask32(q1 + i, q2? q2 + i : 0);
+		LT_UE_WALK_FOR(mm, hq, i);
+	}
+	for (; i + 16 <= n; i += 16) {
+		uint32_t mm = lt_neq_mask16(s1 + i, s2 + i), hq;
+		if (mm == 0) continue;
+		hq = lt_hq_mask16(q1 + i, q2? q2 + i : 0);
+		LT_UE_WALK_FOR(mm, hq, i);
+	}
+	return lt_ue_for1_s(i, n, &pen, s1, q1, s2, q2, min_len, max_pen);
+}
+
+__attribute__((target("avx2")))
+static int lt_ue_rev1_avx2(int i, int n, int pen, int l1, const char *s1, const char *q1, int l2, const char *s2, const char *q2, int min_len, int max_pen)
+{
+	for (; i + 32 <= n; i += 32) {
+		int o1 = l1 - i - 32, o2 = l2 - i - 32;
+		uint32_t mm = lt_neq_mask32(s1 + o1, s2 + o2), hq;
+		if (mm == 0) continue;
+		hq = lt_hq_mask32(q1 + o1, q2? q2 + o2 : 0);
+		LT_UE_WALK_REV(mm, hq, i, 32);
+	}
+	for (; i + 16 <= n; i += 16) {
+		int o1 = l1 - i - 16, o2 = l2 - i - 16;
+		uint32_t mm = lt_neq_mask16(s1 + o1, s2 + o2), hq;
+		if (mm == 0) continue;
+		hq = lt_hq_mask16(q1 + o1, q2? q2 + o2 : 0);
+		LT_UE_WALK_REV(mm, hq, i, 16);
+	}
+	return lt_ue_rev1_s(i, n, &pen, l1, s1, q1, l2, s2, q2, min_len, max_pen);
+}
+
+void lt_simd_init(void)
+{
+	__builtin_cpu_init();
+	lt_simd = __builtin_cpu_supports("avx2")? 2 : 1;
+}
+#else
+void lt_simd_init(void) { lt_simd = 0; }
+#endif
+
+int lt_ue_for1(int l1, const char *s1, const char *q1, int l2, const char *s2, const char *q2, int min_len, int max_pen)
+{
+	int i, pen = 0, n = l1 < l2? l1 : l2;
+#if defined(__x86_64__) && defined(__GNUC__)
+	if (lt_simd && n > LT_UE_HEAD) {
+		if ((i = lt_ue_for1_s(0, LT_UE_HEAD, &pen, s1, q1, s2, q2, min_len, max_pen)) < LT_UE_HEAD) return i;
+		return lt_simd >= 2? lt_ue_for1_avx2(i, n, pen, l1, s1, q1, l2, s2, q2, min_len, max_pen) : lt_ue_for1_sse2(i, n, pen, l1, s1, q1, l2, s2, q2, min_len, max_pen);
+	}
+#endif
+	return lt_ue_for1_s(0, n, &pen, s1, q1, s2, q2, min_len, max_pen);
+}
+
+int lt_ue_rev1(int l1, const char *s1, const char *q1, int l2, const char *s2, const char *q2, int min_len, int max_pen)
+{
+	int i, pen = 0, n = l1 < l2? l1 : l2;
+#if defined(__x86_64__) && defined(__GNUC__)
+	if (lt_simd && n > LT_UE_HEAD) {
+		if ((i = lt_ue_rev1_s(0, LT_UE_HEAD, &pen, l1, s1, q1, l2, s2, q2, min_len, max_pen)) < LT_UE_HEAD) return i;
+		return lt_simd >= 2? lt_ue_rev1_avx2(i, n, pen, l1, s1, q1, l2, s2, q2, min_len, max_pen) : lt_ue_rev1_sse2(i, n, pen, l1, s1, q1, l2, s2, q2, min_len, max_pen);
+	}
+#endif
+	return lt_ue_rev1_s(0, n, &pen, l1, s1, q1, l2, s2, q2, min_len, max_pen);
+}
+
 int lt_ue_for(int l1, const char *s1, const char *q1, int l2, const char *s2, const char *q2, int max_pen, int min_len, int max_pos, uint64_t *pos)
 {
 	int i, n = 0;
@@ -194,408 +331,3166 @@ int lt_ue_contained(int l1, const char *s1, const char *q1, int l2, const char *
 	return n;
 }
 
-/**********************
- * Batch FASTQ reader *
- **********************/
+/****************
+ * Packed reads *
+ ****************/
 
-#include <zlib.h>
-#include "kseq.h"
-KSEQ_INIT(gzFile, gzread)
+/* Reads packed at 2 bits per base (A/C/G/T=0/1/2/3) with a mask of the other bases, one bit at the low end
+ * of their 2-bit slot. Such bases get code 0 and are compared through their bytes, so the packed kernels
+ * below report exactly the mismatches lt_ue_for1() and lt_ue_rev1() would find between the ASCII reads.
+ * The reverse complement is built word by word from the packed forward read and only decoded to ASCII
+ * when the pair is merged. */
 
 typedef struct {
-	uint32_t l_seq:31, dbl_bind:1;
-	enum lt_type_e type;
-	int olig_pos_f, olig_pos_r;
-	int merge_pos_l, merge_pos_r; 
-	char *name, *seq, *qual, *bc_f, *bc_r, *bc_cat;
-} bseq1_t;
+	int l, rc, amb;  // rc: x[] and n[] hold the reverse complement of s[]; amb: n[] is not empty
+	const char *s;   // the ASCII read, for the bases in n[]
+	uint64_t *x, *n; // codes and mask of the other bases; lt_pk_size(l) words each
+} lt_pk_t;
 
-bseq1_t *bseq_read(kseq_t *ks, int chunk_size, int *n_)
+#define lt_pk_size(l) (((l)>>5) + 2)
+
+static inline uint64_t lt_pk_zero8(uint64_t x) // 0x80 in each zero byte of _x_
 {
-	int size = 0, m, n;
-	bseq1_t *seqs;
-	m = n = 0; seqs = 0;
-	while (kseq_read(ks) >= 0) {
-		bseq1_t *s;
-		if (n >= m) {
-			m = m? m<<1 : 256;
-			seqs = realloc(seqs, m * sizeof(bseq1_t));
-		}
-		s = &seqs[n];
-		s->name = strdup(ks->name.s);
-		s->seq = strdup(ks->seq.s);
-		s->qual = ks->qual.l? strdup(ks->qual.s) : 0;
-		s->bc_f = 0;
-		s->bc_r = 0;
-		s->l_seq = ks->seq.l;
-		s->dbl_bind = 0;
-		s->type = LT_UNKNOWN;
-		s->olig_pos_f = 0;
-		s->olig_pos_r = 0;
-		s->merge_pos_l = 0; 
-		s->merge_pos_r = 0; 
-		size += seqs[n++].l_seq;
-		if (size >= chunk_size && (n&1) == 0) break;
-	}
-	*n_ = n;
-	return seqs;
+	return ~(((x & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | x) & 0x8080808080808080ULL;
 }
 
-/*********************************
- * Core trimming/merging routine *
- *********************************/
+static inline uint64_t lt_pk_gather8(uint64_t x) // bits 0-1 of each byte to 16 bits
+{
+	x = (x | x>>6)  & 0x000F000F000F000FULL;
+	x = (x | x>>12) & 0x000000FF000000FFULL;
+	return (x | x>>24) & 0xFFFFULL;
+}
 
-typedef struct {
-	lt_opt_t opt;
-	kseq_t *ks;
-} lt_global_t;
+static inline uint32_t lt_pk_spread16(uint32_t x) // bit i to bit 2i
+{
+	x = (x | x<<8) & 0x00FF00FFU;
+	x = (x | x<<4) & 0x0F0F0F0FU;
+	x = (x | x<<2) & 0x33333333U;
+	return (x | x<<1) & 0x55555555U;
+}
 
-void lt_global_init(lt_global_t *g)
+static inline uint64_t lt_pk_rev32(uint64_t x) // reverse the order of the 32 2-bit slots
 {
-	memset(g, 0, sizeof(lt_global_t));
-	lt_opt_init(&g->opt);
+	x = __builtin_bswap64(x);
+	x = (x>>4 & 0x0F0F0F0F0F0F0F0FULL) | (x & 0x0F0F0F0F0F0F0F0FULL) << 4;
+	return (x>>2 & 0x3333333333333333ULL) | (x & 0x3333333333333333ULL) << 2;
 }
 
-// trim a read by l basepairs from the 5' end
-static inline void trim_bseq_5(bseq1_t *s, int l)
+// the i-th base of _p_ as a byte, the same as lt_seq_revcomp() gives for a reverse complement
+static inline int lt_pk_char(const lt_pk_t *p, int i)
 {
-	memmove(s->seq, s->seq + l, s->l_seq - l);
-	memmove(s->qual, s->qual + l, s->l_seq - l);
-	s->l_seq -= l;
-	s->seq[s->l_seq] = s->qual[s->l_seq] = 0;
+	int c;
+	if (!p->rc) return (uint8_t)p->s[i];
+	c = (uint8_t)p->s[p->l - 1 - i];
+	return c >= 128? 'N' : (uint8_t)comp_tab[c];
 }
 
-static inline int merge_base(int max_qual, int qmask, char fc, char fq, char rc, char rq)
+// w<=32 bases starting from the st-th base
+static inline uint64_t lt_pack2_get(const uint64_t *pk, int st, int w)
 {
-	int y;
-	if (fc == rc) {
-		int q = fq > rq? (fq - 33) + (rq - 33) / 2 : (rq - 33) + (fq - 33) / 2;
-		y = toupper(fc) | (33 + (q < max_qual? q : max_qual)) << 8;
-	} else {
-		if (fq - 33 >= qmask && rq - 33 >= qmask) y = 'N' | 33 << 8;
-		else if (fq > rq) y = toupper(fc) | (33 + (fq - rq)) << 8;
-		else y = toupper(rc) | (33 + (rq - fq)) << 8;
-	}
-	return y;
+	int r = (st&31)<<1;
+	uint64_t x = r? pk[st>>5] >> r | pk[(st>>5) + 1] << (64 - r) : pk[st>>5];
+	return w < 32? x & ((1ULL << (w<<1)) - 1) : x;
 }
 
-static inline void trim_adap(bseq1_t *s, const char *adap, int is_5, int min_len, int max_pen, int allow_contained)
+// pack s[0..l) to _p_; x[] and n[] must have room for lt_pk_size(l) words
+void lt_pk_init(lt_pk_t *p, int l, const char *s, uint64_t *x, uint64_t *n)
 {
-	int n_hits, l_adap;
-	uint64_t hits[4];
-	l_adap = strlen(adap);
-	if (is_5) n_hits = lt_ue_rev(s->l_seq, s->seq, s->qual, l_adap, adap, 0, max_pen, min_len, 4, hits);
-	else n_hits = lt_ue_for(s->l_seq, s->seq, s->qual, l_adap, adap, 0, max_pen, min_len, 4, hits);
-	if (n_hits > 0 && (allow_contained || (hits[0]>>32) + (uint32_t)hits[0] == s->l_seq || (hits[n_hits-1]>>32) + (uint32_t)hits[n_hits-1] == s->l_seq)) {
-		int len = s->l_seq - (hits[n_hits-1]>>32); // trim the longest hit
-		if (is_5) {
-			if (len > min_len) trim_bseq_5(s, len); // trim
-			else memset(s->qual, 33+1, len); // reduce baseQ
-		} else {
-			if (len > min_len) s->l_seq -= len, s->seq[s->l_seq] = s->qual[s->l_seq] = 0; // trim
-			else memset(s->qual + (s->l_seq - len), 33+1, len); // reduce baseQ
+	int i = 0;
+	p->l = l, p->rc = 0, p->amb = 0, p->s = s, p->x = x, p->n = n;
+	memset(x, 0, lt_pk_size(l) * sizeof(uint64_t));
+	memset(n, 0, lt_pk_size(l) * sizeof(uint64_t));
+#if defined(__x86_64__) && defined(__GNUC__)
+	if (lt_simd) { // 16 bases at a time; code bits 1 and 0 are c>>2&1 and (c>>1^c>>2)&1
+		__m128i A = _mm_set1_epi8('A'), C = _mm_set1_epi8('C'), G = _mm_set1_epi8('G'), T = _mm_set1_epi8('T');
+		for (; i + 16 <= l; i += 16) {
+			__m128i v = _mm_loadu_si128((const __m128i*)(s + i)), e;
+			uint32_t hi, lo, a;
+			e = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, A), _mm_cmpeq_epi8(v, C)), _mm_or_si128(_mm_cmpeq_epi8(v, G), _mm_cmpeq_epi8(v, T)));
+			a = ~_mm_movemask_epi8(e) & 0xffff;
+			hi = _mm_movemask_epi8(_mm_slli_epi16(v, 5));
+			lo = _mm_movemask_epi8(_mm_slli_epi16(_mm_xor_si128(v, _mm_srli_epi16(v, 1)), 6));
+			a = lt_pk_spread16(a);
+			x[i>>5] |= (uint64_t)((lt_pk_spread16(lo) | lt_pk_spread16(hi) << 1) & ~(a * 3)) << ((i&31)<<1);
+			n[i>>5] |= (uint64_t)a << ((i&31)<<1);
 		}
 	}
+#endif
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	for (; i + 8 <= l; i += 8) { // 8 bases at a time; s[i] is in the lowest byte
+		uint64_t v, a, c;
+		memcpy(&v, s + i, 8);
+		a = lt_pk_zero8(v ^ 0x4141414141414141ULL) | lt_pk_zero8(v ^ 0x4343434343434343ULL)
+			| lt_pk_zero8(v ^ 0x4747474747474747ULL) | lt_pk_zero8(v ^ 0x5454545454545454ULL);
+		a = (~a & 0x8080808080808080ULL) >> 7; // 1 for bases other than A/C/G/T
+		c = ((v>>1 & 0x0303030303030303ULL) ^ (v>>2 & 0x0101010101010101ULL)) & ~(a * 3); // A/C/G/T are 0/1/3/2 in (c>>1&3)
+		x[i>>5] |= lt_pk_gather8(c) << ((i&31)<<1);
+		n[i>>5] |= lt_pk_gather8(a) << ((i&31)<<1);
+	}
+#endif
+	for (; i < l; ++i) {
+		int c = s[i] == 'A'? 0 : s[i] == 'C'? 1 : s[i] == 'G'? 2 : s[i] == 'T'? 3 : 4;
+		if (c < 4) x[i>>5] |= (uint64_t)c << ((i&31)<<1);
+		else n[i>>5] |= 1ULL << ((i&31)<<1);
+	}
+	for (i = 0; i <= l>>5; ++i) p->amb |= (n[i] != 0);
 }
 
-//By Bowen Jin
-static inline void trim_olig_bc(bseq1_t *s, const char *Tn5_barcode[], int is_5, int min_len, int max_pen, int *trim_pos, char *trim_seq, int if_output)
+// reverse complement _f_ to _r_, with room for lt_pk_size(f->l) words in x[] and n[]
+void lt_pk_revcomp(const lt_pk_t *f, lt_pk_t *r, uint64_t *x, uint64_t *n)
 {
-	int n_hits_bc, l_bc, n_hits;
-	uint64_t hits[16];
-	
-	for (int i = 0; i < 16; i++){ 
-		l_bc = strlen(Tn5_barcode[i]);
-		if (is_5) n_hits_bc = lt_ue_for(s->l_seq, s->seq, s->qual, l_bc, Tn5_barcode[i], 0, max_pen, min_len, 16, hits);
-		else n_hits_bc = lt_ue_rev(s->l_seq, s->seq, s->qual, l_bc, Tn5_barcode[i], 0, max_pen, min_len, 16, hits);
-		if(n_hits_bc == 1) {
-			int len = l_bc + 19;
-
-			if (strlen(s->seq) <= len) {return;}
-
-			if (is_5) {
-				if (len > min_len) { // trim
-					if (if_output) {
-						strncpy(trim_seq, s->seq, len);
-						trim_seq[len] = 0;
-						*trim_pos = len;
-					}
-					trim_bseq_5(s, len); 
-				} else {
-					memset(s->qual, 33+1, len); // reduce baseQ
-				}
-			} else {
-				if (len > min_len) {  // trim
-					s->l_seq -= len, s->seq[s->l_seq] = s->qual[s->l_seq] = 0;
-				} else {
-					memset(s->qual + (s->l_seq - len), 33+1, len); // reduce baseQ
-				}
-			}
+	int i, nw = (f->l + 31) >> 5, sh = ((nw<<5) - f->l) << 1; // sh: bits of padding at the start after reversal
+	r->l = f->l, r->rc = !f->rc, r->amb = f->amb, r->s = f->s, r->x = x, r->n = n;
+	for (i = 0; i < nw; ++i) {
+		n[i] = lt_pk_rev32(f->n[nw - 1 - i]);
+		x[i] = ~lt_pk_rev32(f->x[nw - 1 - i]) & ~(n[i] * 3); // complement: A<->T and C<->G are 0<->3 and 1<->2
+	}
+	x[nw] = n[nw] = 0;
+	if (sh)
+		for (i = 0; i < nw; ++i)
+			x[i] = x[i] >> sh | x[i+1] << (64 - sh), n[i] = n[i] >> sh | n[i+1] << (64 - sh);
+	if (f->l & 31) {
+		uint64_t m = (1ULL << ((f->l&31)<<1)) - 1;
+		x[nw - 1] &= m, n[nw - 1] &= m;
+	}
+	for (i = 0; r->amb && i < nw; ++i) { // comp_tab[] takes "U" to "A"
+		uint64_t m;
+		for (m = n[i]; m; m &= m - 1) {
+			int j = __builtin_ctzll(m);
+			if (lt_pk_char(r, i<<5 | j>>1) == 'A') n[i] &= ~(1ULL << j); // and the code is already 0
 		}
 	}
 }
-//
 
-void lt_process(const lt_global_t *g, bseq1_t s[2])
+// decode _p_ to s[0..p->l]
+void lt_pk_decode(const lt_pk_t *p, char *s)
 {
-	int i, k, mlen, oligo_len=19;
-	mlen = s[0].l_seq > s[1].l_seq? s[0].l_seq : s[1].l_seq;
-
-	// trim heading and trailing N
-	for (k = 0; k < 2; ++k) {
-		bseq1_t *sk = &s[k];
-		for (i = sk->l_seq - 1; i >= 0; --i) // trim trailing "N"
-			if (sk->seq[i] != 'N') break;
-		sk->l_seq = i + 1;
-		sk->seq[sk->l_seq] = sk->qual[sk->l_seq] = 0;
-		for (i = 0; i < sk->l_seq; ++i) // trim heading "N"
-			if (sk->seq[i] != 'N') break;
-		if (i) trim_bseq_5(sk, i);
+	int i = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	for (; i + 8 <= p->l; i += 8) { // 8 bases at a time: codes to bytes, then 'A'+{0,2,6,19}
+		uint64_t x = p->x[i>>5] >> ((i&31)<<1) & 0xFFFF, b0, b1;
+		x = (x | x<<24) & 0x000000FF000000FFULL;
+		x = (x | x<<12) & 0x000F000F000F000FULL;
+		x = (x | x<<6)  & 0x0303030303030303ULL;
+		b0 = x & 0x0101010101010101ULL, b1 = x>>1 & 0x0101010101010101ULL;
+		x = 0x4141414141414141ULL + b0 * 2 + b1 * 6 + (b0 & b1) * 11;
+		memcpy(s + i, &x, 8);
 	}
-	
-	// trim Illumina PE adapters
-	trim_adap(&s[0], lt_adapter1, 0, g->opt.min_adap_len, g->opt.max_adap_pen, 1);
-	trim_adap(&s[1], lt_adapter2, 0, g->opt.min_adap_len, g->opt.max_adap_pen, 1);
-	
-	// trim transposon sequences and store barcodes
-	int olig_pos[2];
-	char *bc[2];
-	
-	for (k = 0; k < 2; ++k) {
-		olig_pos[k] = 0;
-		bc[k] = (char*)alloca(mlen + 1);
-		bc[k][0] = 0;
-		//By Bowen Jin
-        trim_olig_bc(&s[k], Tn5_barcode, 1, 11, 0, &olig_pos[k], bc[k], 1);
-		trim_olig_bc(&s[k], Tn5_barcode, 0, 11, 0, 0, 0, 0); 
-		//
+#endif
+	for (; i < p->l; ++i)
+		s[i] = "ACGT"[p->x[i>>5] >> ((i&31)<<1) & 3];
+	for (i = 0; p->amb && i <= p->l>>5; ++i) {
+		uint64_t m;
+		for (m = p->n[i]; m; m &= m - 1)
+			s[i<<5 | __builtin_ctzll(m)>>1] = lt_pk_char(p, i<<5 | __builtin_ctzll(m)>>1);
 	}
+	s[p->l] = 0;
+}
 
-	
-	{ // merge the two ends
-		int n_fh, n_rh, n_ch;
-		uint64_t fh[2], rh[2], ch[2];
-		char *rseq, *rqual, *xseq, *xqual;
-		rseq = (char*)alloca(mlen + 1);
-		rqual = (char*)alloca(mlen + 1);
-		xseq = (char*)alloca(s[0].l_seq + s[1].l_seq + 1);
-		xqual = (char*)alloca(s[0].l_seq + s[1].l_seq + 1);
-		// reverse the other read
-		lt_seq_revcomp(s[1].l_seq, s[1].seq, rseq);
-		lt_seq_rev(s[1].l_seq, s[1].qual, rqual);
-		// find overlaps
-		n_fh = lt_ue_for(s[0].l_seq, s[0].seq, s[0].qual, s[1].l_seq, rseq, rqual, g->opt.max_ovlp_pen, g->opt.min_ovlp_len, 2, fh);
-		if (fh[0]>>32 == 0 && s[0].l_seq == s[1].l_seq && (int32_t)fh[0] == s[0].l_seq) n_rh = 0; // complete overlap; don't test ue_rev()
-		else n_rh = lt_ue_rev(s[0].l_seq, &s[0].seq[0], &s[0].qual[0], s[1].l_seq, rseq, rqual, g->opt.max_ovlp_pen, g->opt.min_ovlp_len, 2, rh);
-		n_ch = lt_ue_contained(s[0].l_seq, &s[0].seq[0], &s[0].qual[0], s[1].l_seq, rseq, rqual, g->opt.max_ovlp_pen, 2, ch);
-		if (n_fh + n_rh + n_ch > 1) {
-			s[0].type = s[1].type = LT_MERGE_AMBIGUOUS;
-		} else if (n_fh + n_rh + n_ch == 0) {
-			s[0].type = s[1].type = LT_NO_MERGE;
-		} else {
-			int x = 0;
-			if (n_fh == 1) {
-				int l = (uint32_t)fh[0], st = fh[0]>>32;
-				if (l < s[1].l_seq) { // partial overlap
-					s[0].type = s[1].type = LT_MERGE_PARTIAL;
-					s[0].merge_pos_l = s[1].merge_pos_l = st;
-					s[0].merge_pos_r = s[1].merge_pos_r = st + l - 1;
-					for (i = 0; i < st; ++i) // read1 non-overlap
-						xseq[x] = s[0].seq[i], xqual[x++] = s[0].qual[i];
-					for (i = 0; i < l; ++i) { // overlap (l=length of overlap)
-						int j = st + i, y;
-						y = merge_base(g->opt.max_qual, g->opt.qmask, s[0].seq[j], s[0].qual[j], rseq[i], rqual[i]);
-						xseq[x] = (uint8_t)y, xqual[x++] = y>>8;
-					}
-					for (i = l; i < s[1].l_seq; ++i) // read2 non-overlap
-						xseq[x] = rseq[i], xqual[x++] = rqual[i];
-				} else { // s[1] is contained in s[0]
-					s[0].type = s[1].type = LT_MERGE_COMPLETE_FH;
-					s[0].merge_pos_l = s[1].merge_pos_l = st;
-					s[0].merge_pos_r = s[1].merge_pos_r = st + l - 1;
-					for (i = 0; i < l; ++i) { // discard the non-overlapping fragment which is likely to be transposon BC/adapter from the other read
-						int j = st + i, y;
-						y = merge_base(g->opt.max_qual, g->opt.qmask, s[0].seq[j], s[0].qual[j], rseq[i], rqual[i]);
-						xseq[x] = (uint8_t)y, xqual[x++] = y>>8;
-					}
-				}
-			} else if (n_rh == 1) { // s[1] is contained in s[0], i.e. s[0] non-overlap left + l/s[1], discard s[0] non-overlap right
-				int l = (uint32_t)rh[0], st = rh[0]>>32;
-				s[0].type = s[1].type = LT_MERGE_COMPLETE_RH;
-				s[0].merge_pos_l = s[1].merge_pos_l = s[0].l_seq - st - l;
-				s[0].merge_pos_r = s[1].merge_pos_r = s[0].l_seq - st - 1;
-				for (i = 0; i < s[0].l_seq - st - l; ++i)
-					xseq[x] = s[0].seq[i], xqual[x++] = s[0].qual[i];
-				for (i = s[1].l_seq - l; i < s[1].l_seq; ++i) {
-					int j = i - s[1].l_seq + (s[0].l_seq - st), y;
-					y = merge_base(g->opt.max_qual, g->opt.qmask, s[0].seq[j], s[0].qual[j], rseq[i], rqual[i]);
-					xseq[x] = (uint8_t)y, xqual[x++] = y>>8;
-				}
-			} else { // s[0] is contained in s[1]
-				int j, st = ch[0]>>32;
-				s[0].type = s[1].type = LT_MERGE_COMPLETE_CH;
-				s[0].merge_pos_l = s[1].merge_pos_l = 0;
-				s[0].merge_pos_r = s[1].merge_pos_r = s[0].l_seq - 1;
-				for (j = 0; j < s[0].l_seq; ++j) {
-					int i = j + st, y;
-					y = merge_base(g->opt.max_qual, g->opt.qmask, s[0].seq[j], s[0].qual[j], rseq[i], rqual[i]);
-					xseq[x] = (uint8_t)y, xqual[x++] = y>>8;
-				}
-			}
-			xseq[x] = xqual[x] = 0;
-			if (x < g->opt.min_seq_len) s[0].type = s[1].type = LT_SHORT_SEQ;
-			free(s[0].seq); free(s[0].qual);
-			s[0].seq = strdup(xseq);
-			s[0].qual = strdup(xqual);
-			s[0].l_seq = x;
-			s[1].l_seq = 0;
-		}
-	}
-	
-	// check whether read length is too short
-    if (s[0].l_seq < g->opt.min_seq_len) {
-        if (s[0].type == LT_MERGE_PARTIAL || s[0].type == LT_MERGE_COMPLETE || s[0].type == LT_MERGE_COMPLETE_FH || s[0].type == LT_MERGE_COMPLETE_RH || s[0].type == LT_MERGE_COMPLETE_CH ) { // single-end
-            s[0].type = s[1].type = LT_SHORT_SEQ;
-        } else if (s[1].l_seq >= g->opt.min_seq_len) { // read 1 is short, but read 2 is not => swap
-			char *tmp;
-			tmp = s[0].seq, s[0].seq = s[1].seq, s[1].seq = tmp;
-			tmp = s[0].qual, s[0].qual = s[1].qual, s[1].qual = tmp;
-			tmp = bc[0], bc[0] = bc[1], bc[1] = tmp;
-			i = olig_pos[0], olig_pos[0] = olig_pos[1], olig_pos[1] = i;
-			i = s[0].l_seq, s[0].l_seq = s[1].l_seq, s[1].l_seq = i;
-            s[0].type = s[1].type = LT_SHORT_PE_SWAP;
-        } else {
-            s[0].type = s[1].type = LT_SHORT_SEQ;
-        }
-    } else if (s[0].type != LT_MERGE_PARTIAL && s[0].type != LT_MERGE_COMPLETE && s[0].type != LT_MERGE_COMPLETE_FH && s[0].type != LT_MERGE_COMPLETE_RH && s[0].type != LT_MERGE_COMPLETE_CH && s[1].l_seq < g->opt.min_seq_len) { // read 2 is short, but read 1 is not
-        s[0].type = s[1].type = LT_SHORT_PE;
-    }
-    
-    // record the barcodes
-	for (k = 0; k < 2; ++k) {
-		s[k].olig_pos_f = olig_pos[0];
-		s[k].olig_pos_r = olig_pos[1];
-		s[k].bc_f = strdup(bc[0]);
-		s[k].bc_r = strdup(bc[1]);
-		if (s[k].olig_pos_f > oligo_len + g->opt.bc_cut && s[k].olig_pos_r > oligo_len + g->opt.bc_cut) {
-			int l[2];
-			l[0] = s[k].olig_pos_f - (oligo_len + g->opt.bc_cut);
-			l[1] = s[k].olig_pos_r - (oligo_len + g->opt.bc_cut);
-			s[k].bc_cat = (char*)calloc(l[0] + l[1] + 1, 1);
-			strncpy(s[k].bc_cat,        &s[k].bc_f[g->opt.bc_cut], l[0]);
-			strncpy(&s[k].bc_cat[l[0]], &s[k].bc_r[g->opt.bc_cut], l[1]);
-		} else s[k].bc_cat = 0;
+// mismatches between a[sa,sa+w) and b[sb,sb+w), w<=32, at the low bit of each 2-bit slot
+static inline uint64_t lt_pk_diff(const lt_pk_t *a, int sa, const lt_pk_t *b, int sb, int w)
+{
+	uint64_t x, m, na, nb;
+	x = lt_pack2_get(a->x, sa, w) ^ lt_pack2_get(b->x, sb, w);
+	x = (x | x>>1) & 0x5555555555555555ULL;
+	if (!a->amb && !b->amb) return x;
+	na = a->amb? lt_pack2_get(a->n, sa, w) : 0;
+	nb = b->amb? lt_pack2_get(b->n, sb, w) : 0;
+	x = (x & ~(na | nb)) | (na ^ nb);
+	for (m = na & nb; m; m &= m - 1) { // compare the other bases by bytes
+		int j = __builtin_ctzll(m) >> 1;
+		if (lt_pk_char(a, sa + j) != lt_pk_char(b, sb + j)) x |= 1ULL << (j<<1);
 	}
+	return x;
 }
 
-/**********************
- * Callback functions *
- **********************/
-
-void kt_for(int n_threads, void (*func)(void*,long,int), void *data, long n);
-void kt_pipeline(int n_threads, void *(*func)(void*, int, void*), void *shared_data, int n_steps);
-
-typedef struct {
-	int n_seqs;
-	bseq1_t *seqs;
-	lt_global_t *g;
-} data_for_t;
-
-static void worker_for(void *_data, long i, int tid)
+// true if the mismatches in _x_, XOR of the first _w_ codes, are enough for lt_ue_for1() to stop
+static inline int lt_pk_stop(uint64_t x, int w, int min_len, int max_pen)
 {
-	data_for_t *data = (data_for_t*)_data;
-	lt_process(data->g, &data->seqs[i<<1]);
+	int c;
+	x = (x | x>>1) & 0x5555555555555555ULL;
+	c = __builtin_popcountll(x) * LT_LOW_PEN;
+	return c > max_pen && c * min_len > (w - 1) * max_pen; // pen > max(max_pen, (w-1)*max_pen/min_len)
 }
 
-static void *worker_pipeline(void *shared, int step, void *_data)
+// lt_ue_for1() on a[sa..] and b[sb..], with qa/qb pointing to the qualities at sa/sb; n bases at most
+static int lt_ue_for1_pk(const lt_pk_t *a, int sa, const char *qa, const lt_pk_t *b, int sb, const char *qb, int n, int min_len, int max_pen)
 {
-	int i;
-	lt_global_t *g = (lt_global_t*)shared;
-	if (step == 0) {
-		data_for_t *ret;
-		ret = calloc(1, sizeof(data_for_t));
-		ret->seqs = bseq_read(g->ks, g->opt.chunk_size, &ret->n_seqs);
-		assert((ret->n_seqs&1) == 0);
-		ret->g = g;
-		if (ret->seqs) return ret;
-		else free(ret);
-	} else if (step == 1) {
-		data_for_t *data = (data_for_t*)_data;
-		kt_for(g->opt.n_threads, worker_for, data, data->n_seqs>>1);
-		return data;
-	} else if (step == 2) {
-		data_for_t *data = (data_for_t*)_data;
-		if (g->opt.tab_out) { // tabular output
-			for (i = 0; i < data->n_seqs; i += 2) {
-				bseq1_t *s = &data->seqs[i];
-				bseq1_t *s_r = &data->seqs[i+1];        
-				printf("%s\t%d\t%d\t%d\t%d\t%d\t%zd\t%zd\n", s->name, s->type, s->merge_pos_l, s->merge_pos_r, s->olig_pos_f, s->olig_pos_r, strlen(s->seq),strlen(s_r->seq)); 
-			}
-		} else { // FASTQ output (FASTA not supported yet)
-			for (i = 0; i < data->n_seqs; ++i) {
-				bseq1_t *s = &data->seqs[i];
-				if (s->l_seq > 0 && (s->type == LT_NO_MERGE || s->type == LT_MERGE_AMBIGUOUS || s->type == LT_MERGE_PARTIAL || s->type == LT_MERGE_COMPLETE || s[0].type == LT_MERGE_COMPLETE_FH || s[0].type == LT_MERGE_COMPLETE_RH || s[0].type == LT_MERGE_COMPLETE_CH || (s->type == LT_SHORT_PE && ~i&1)) ) {
-					putchar(s->qual? '@' : '>'); fputs(s->name, stdout);
-					if (s->type == LT_NO_MERGE || s->type == LT_MERGE_AMBIGUOUS) {
-						putchar('/'); putchar("12"[i&1]);
-					}
-					printf(" YT:i:%d", s->type);
-					printf("\tML:i:%d", s->merge_pos_l); 
-					printf("\tMR:i:%d", s->merge_pos_r); 
-					if (s->bc_cat) { fputs("\tBC:Z:", stdout); fputs(s->bc_cat, stdout); }
-					else fputs("\tBC:Z:*", stdout);
-					printf("\tPF:i:%d", s->olig_pos_f);
-					printf("\tPR:i:%d", s->olig_pos_r);
-					if (s->bc_f) { fputs("\tBF:Z:", stdout); fputs(s->bc_f[0] == 0? "*" : s->bc_f, stdout); }
-					if (s->bc_r) { fputs("\tBR:Z:", stdout); fputs(s->bc_r[0] == 0? "*" :s->bc_r, stdout); }
-					putchar('\n');
-					puts(s->seq);
-					if (s->qual) { puts("+"); puts(s->qual); }
-				}
-			}
-		}
-		for (i = 0; i < data->n_seqs; ++i) { // deallocate
-			bseq1_t *s = &data->seqs[i];
-			free(s->bc_cat); free(s->bc_f); free(s->bc_r); free(s->seq); free(s->qual); free(s->name);
+	int i, pen = 0;
+	for (i = 0; i < n; i += 32) {
+		int w = n - i < 32? n - i : 32;
+		uint64_t x = lt_pk_diff(a, sa + i, b, sb + i, w);
+		for (; x; x &= x - 1) {
+			int j = i + (__builtin_ctzll(x) >> 1);
+			pen += qa[j] >= LT_QUAL_THRES && qb[j] >= LT_QUAL_THRES? LT_HIGH_PEN : LT_LOW_PEN;
+			if (lt_ue_stop(pen, j, min_len, max_pen)) return j;
 		}
-		free(data->seqs); free(data);
 	}
-	return 0;
+	return n;
 }
 
-#include <unistd.h>
-
-int main(int argc, char *argv[])
+// lt_ue_rev1() on a[0,ea) and b[0,eb), backwards from the ends; n bases at most
+static int lt_ue_rev1_pk(const lt_pk_t *a, int ea, const char *qa, const lt_pk_t *b, int eb, const char *qb, int n, int min_len, int max_pen)
 {
-	int c;
-	lt_global_t g;
-	gzFile fp;
+	int i, pen = 0;
+	for (i = 0; i < n; i += 32) {
+		int w = n - i < 32? n - i : 32;
+		uint64_t x = lt_pk_diff(a, ea - i - w, b, eb - i - w, w);
+		while (x) {
+			int k = (63 - __builtin_clzll(x)) >> 1, j = i + w - 1 - k;
+			pen += qa[ea-1-j] >= LT_QUAL_THRES && qb[eb-1-j] >= LT_QUAL_THRES? LT_HIGH_PEN : LT_LOW_PEN;
+			if (lt_ue_stop(pen, j, min_len, max_pen)) return j;
+			x &= ~(1ULL << (k<<1));
+		}
+	}
+	return n;
+}
 
-	lt_global_init(&g);
-	while ((c = getopt(argc, argv, "Tt:b:l:c:q:")) >= 0) {
-		if (c == 't') g.opt.n_threads = atoi(optarg);
+/* The same as lt_ue_for() on packed reads. Every mismatch costs at least LT_LOW_PEN, so an offset with
+ * enough mismatches in its first (up to) 32 bases to stop is skipped without lt_ue_for1_pk(). The other
+ * bases have code 0 and may only be undercounted by comparing the codes alone. */
+int lt_ue_for_pk(const lt_pk_t *a, const char *q1, const lt_pk_t *b, const char *q2, int max_pen, int min_len, int max_pos, uint64_t *pos)
+{
+	int i, n = 0, l1 = a->l, l2 = b->l;
+	for (i = min_len; i <= l1; ++i) {
+		int l, w = i < l2? i : l2;
+		w = w < 32? w : 32;
+		if (lt_pk_stop(lt_pack2_get(a->x, l1 - i, w) ^ (w < 32? b->x[0] & ((1ULL << (w<<1)) - 1) : b->x[0]), w, min_len, max_pen)) continue;
+		l = lt_ue_for1_pk(a, l1 - i, q1 + l1 - i, b, 0, q2, i < l2? i : l2, min_len, max_pen);
+		if (l >= min_len && (l == i || l == l2)) {
+			pos[n++] = (uint64_t)(l1 - i) << 32 | l;
+			if (n == max_pos) return n;
+		}
+	}
+	return n;
+}
+
+// the same as lt_ue_rev() on packed reads
+int lt_ue_rev_pk(const lt_pk_t *a, const char *q1, const lt_pk_t *b, const char *q2, int max_pen, int min_len, int max_pos, uint64_t *pos)
+{
+	int i, n = 0, l1 = a->l, l2 = b->l;
+	for (i = min_len; i <= l1; ++i) {
+		int l, w = i < l2? i : l2;
+		w = w < 32? w : 32;
+		if (lt_pk_stop(lt_pack2_get(a->x, i - w, w) ^ lt_pack2_get(b->x, l2 - w, w), w, min_len, max_pen)) continue;
+		l = lt_ue_rev1_pk(a, i, q1, b, l2, q2, i < l2? i : l2, min_len, max_pen);
+		if (l >= min_len && (l == i || l == l2)) {
+			pos[n++] = (uint64_t)(l1 - i) << 32 | l;
+			if (n == max_pos) return n;
+		}
+	}
+	return n;
+}
+
+// the same as lt_ue_contained() on packed reads
+int lt_ue_contained_pk(const lt_pk_t *a, const char *q1, const lt_pk_t *b, const char *q2, int max_pen, int max_pos, uint64_t *pos)
+{
+	int i, n = 0, l1 = a->l, l2 = b->l;
+	for (i = 1; i < l2 - l1; ++i) {
+		int l, w = l1 < 32? l1 : 32;
+		if (lt_pk_stop(lt_pack2_get(a->x, 0, w) ^ lt_pack2_get(b->x, i, w), w, l1, max_pen)) continue;
+		l = lt_ue_for1_pk(a, 0, q1, b, i, q2 + i, l1, l1, max_pen);
+		if (l == l1) {
+			pos[n++] = (uint64_t)i << 32 | l;
+			if (n == max_pos) return n;
+		}
+	}
+	return n;
+}
+
+/*****************
+ * Barcode index *
+ *****************/
+
+/* An Aho-Corasick automaton over the Tn5 barcodes. One pass over a read reports the exact occurrences of all
+ * barcodes; trim_olig_bc() then counts, for each barcode, the hits that lt_ue_for()/lt_ue_rev() would
+ * report with max_pen=0 on the current (possibly trimmed) read. */
+
+typedef struct {
+	int n, max_len, max_out; // max_out: max number of barcodes ending at the same position
+	int *len;
+	char **seq;
+	int n_nodes;
+	int32_t (*next)[4]; // complete transition table; node 0 is the root
+	int32_t *out, *olink; // out: barcode ending at the node or -1; olink: next node with out>=0 on the suffix chain
+} lt_bcidx_t;
+
+static const uint8_t lt_nt4_table[256] = {
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 0, 4, 1,  4, 4, 4, 2,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 4, 4, 4,  3, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4
+}; // only upper-case ACGT; lt_ue_for1() compares bytes, so "a" does not match "A"
+
+void lt_bcidx_destroy(lt_bcidx_t *bi)
+{
+	int i;
+	if (bi == 0) return;
+	for (i = 0; i < bi->n; ++i) free(bi->seq[i]);
+	free(bi->seq); free(bi->len);
+	free(bi->next); free(bi->out); free(bi->olink);
+	free(bi);
+}
+
+// build the index from _n_ barcodes; duplicates are dropped. Return NULL on a non-ACGT barcode.
+lt_bcidx_t *lt_bcidx_init(int n, const char **seq)
+{
+	lt_bcidx_t *bi;
+	int i, j, c, m, *q, qh, qt;
+	bi = (lt_bcidx_t*)calloc(1, sizeof(lt_bcidx_t));
+	bi->len = (int*)calloc(n, sizeof(int));
+	bi->seq = (char**)calloc(n, sizeof(char*));
+	for (i = m = 0; i < n; ++i) {
+		for (j = 0; j < bi->n; ++j)
+			if (strcmp(bi->seq[j], seq[i]) == 0) break;
+		if (j < bi->n) continue; // a duplicate
+		for (j = 0; seq[i][j]; ++j)
+			if (lt_nt4_table[(uint8_t)seq[i][j]] > 3) break;
+		if (seq[i][j] || j == 0) {
+			fprintf(stderr, "[E::%s] barcode '%s' is empty or not made of A/C/G/T\n", __func__, seq[i]);
+			lt_bcidx_destroy(bi);
+			return 0;
+		}
+		bi->len[bi->n] = j, bi->seq[bi->n++] = strdup(seq[i]);
+		bi->max_len = bi->max_len > j? bi->max_len : j;
+		m += j;
+	}
+	// the trie
+	bi->next = (int32_t(*)[4])malloc((m + 1) * sizeof(*bi->next));
+	bi->out = (int32_t*)malloc((m + 1) * sizeof(int32_t));
+	bi->olink = (int32_t*)calloc(m + 1, sizeof(int32_t));
+	memset(bi->next, 0xff, (m + 1) * sizeof(*bi->next));
+	bi->n_nodes = 1, bi->out[0] = -1;
+	for (i = 0; i < bi->n; ++i) {
+		int v = 0;
+		for (j = 0; j < bi->len[i]; ++j) {
+			c = lt_nt4_table[(uint8_t)bi->seq[i][j]];
+			if (bi->next[v][c] < 0)
+				bi->out[bi->n_nodes] = -1, bi->next[v][c] = bi->n_nodes++;
+			v = bi->next[v][c];
+		}
+		bi->out[v] = i;
+	}
+	// suffix links by BFS, turning the trie into a complete automaton; q[] keeps (node, link) pairs
+	q = (int*)malloc(bi->n_nodes * 2 * sizeof(int));
+	qh = qt = 0;
+	for (c = 0; c < 4; ++c) {
+		if (bi->next[0][c] < 0) bi->next[0][c] = 0;
+		else q[qt++] = bi->next[0][c], q[qt++] = 0;
+	}
+	while (qh < qt) {
+		int v = q[qh++], f = q[qh++];
+		bi->olink[v] = bi->out[f] >= 0? f : bi->olink[f];
+		for (c = 0; c < 4; ++c) {
+			int u = bi->next[v][c];
+			if (u < 0) bi->next[v][c] = bi->next[f][c];
+			else q[qt++] = u, q[qt++] = bi->next[f][c];
+		}
+	}
+	free(q);
+	for (i = 1; i < bi->n_nodes; ++i) {
+		int v, k = 0;
+		for (v = bi->out[i] >= 0? i : bi->olink[i]; v > 0; v = bi->olink[v]) ++k;
+		bi->max_out = bi->max_out > k? bi->max_out : k;
+	}
+	return bi;
+}
+
+// load barcodes, one per line; a "FWD-REV" pair is split into two barcodes
+lt_bcidx_t *lt_bcidx_load(const char *fn)
+{
+	FILE *fp;
+	char line[1024], *p, *q, **a = 0;
+	int n = 0, m = 0;
+	lt_bcidx_t *bi;
+	if ((fp = fopen(fn, "r")) == 0) return 0;
+	while (fgets(line, sizeof(line), fp)) {
+		for (p = line; *p && !isspace((uint8_t)*p); ++p);
+		*p = 0;
+		for (p = line; *p; p = *q? q + 1 : q) {
+			for (q = p; *q && *q != '-'; ++q);
+			if (n == m) {
+				m = m? m<<1 : 16;
+				a = (char**)realloc(a, m * sizeof(char*));
+			}
+			a[n++] = strndup(p, q - p);
+		}
+	}
+	fclose(fp);
+	bi = n? lt_bcidx_init(n, (const char**)a) : 0;
+	while (n > 0) free(a[--n]);
+	free(a);
+	return bi;
+}
+
+static inline __attribute__((always_inline)) int lt_bcidx_scan1(const int32_t (*next)[4], const int32_t *out, const int32_t *olink, const int *len, int l, const char *s, uint64_t *hits)
+{
+	int i, v = 0, n = 0;
+	for (i = 0; i < l; ++i) {
+		int u, c = lt_nt4_table[(uint8_t)s[i]];
+		if (c > 3) {
+			v = 0;
+			continue;
+		}
+		v = next[v][c];
+		for (u = out[v] >= 0? v : olink[v]; u > 0; u = olink[u])
+			hits[n++] = (uint64_t)(i + 1 - len[out[u]]) << 32 | out[u];
+	}
+	return n;
+}
+
+// collect exact barcode hits in s[0..l); each hit is (start<<32 | barcode_id), sorted by the end position.
+// _hits_ must have room for l*bi->max_out entries.
+static int lt_bcidx_scan(const lt_bcidx_t *bi, int l, const char *s, uint64_t *hits)
+{
+	return lt_bcidx_scan1((const int32_t(*)[4])bi->next, bi->out, bi->olink, bi->len, l, s, hits);
+}
+
+/******************
+ * Barcode rescue *
+ ******************/
+
+/* With -r, a read without an exact barcode at its 5'-end is matched against every sequence within the given
+ * Hamming distance of a barcode followed by the transposon. The variants are packed at 2 bits per base into
+ * one hash table per prefix length, so rescuing a read end takes one lookup per barcode length. A variant
+ * equally close to two barcodes is ambiguous and never rescued. */
+
+#include "khash.h"
+KHASH_MAP_INIT_INT64(bcr, uint32_t)
+
+#define LT_BCR_MAX_DIST 3
+#define LT_BCR_AMBI     0xffff // in the lower 16 bits of a value: the variant is equally close to 2+ barcodes
+
+typedef struct {
+	int max_dist, n_len;
+	int len[32];            // distinct prefix lengths in the ascending order; a prefix fits in 64 bits
+	khash_t(bcr) *h[32];    // h[i] keeps the variants of length len[i]; value: barcode_id | distance<<16
+	int64_t n_var, n_ambi;
+} lt_bcres_t;
+
+void lt_bcres_destroy(lt_bcres_t *br)
+{
+	int i;
+	if (br == 0) return;
+	for (i = 0; i < br->n_len; ++i) kh_destroy(bcr, br->h[i]);
+	free(br);
+}
+
+static void lt_bcres_add(khash_t(bcr) *h, uint64_t x, int id, int d)
+{
+	int absent;
+	khint_t k;
+	k = kh_put(bcr, h, x, &absent);
+	if (absent) kh_val(h, k) = id | d<<16;
+	else if ((int)(kh_val(h, k)>>16) > d) kh_val(h, k) = id | d<<16; // closer to this barcode
+	else if ((int)(kh_val(h, k)>>16) == d && (int)(kh_val(h, k)&0xffff) != id) kh_val(h, k) = LT_BCR_AMBI | d<<16;
+}
+
+// add _x_ and its variants with up to _max_dist_-_d_ more substitutions at positions _st_ or after
+static void lt_bcres_enum(khash_t(bcr) *h, int l, uint64_t x, int st, int d, int max_dist, int id)
+{
+	int i, c;
+	lt_bcres_add(h, x, id, d);
+	if (d == max_dist) return;
+	for (i = st; i < l; ++i) {
+		int sh = (l - 1 - i) * 2, c0 = x>>sh & 3;
+		for (c = 0; c < 4; ++c)
+			if (c != c0) lt_bcres_enum(h, l, (x & ~(3ULL<<sh)) | (uint64_t)c<<sh, i + 1, d + 1, max_dist, id);
+	}
+}
+
+// index the variants of barcode+_oligo_ within _max_dist_ substitutions; barcodes too long to pack are skipped
+lt_bcres_t *lt_bcres_init(const lt_bcidx_t *bi, const char *oligo, int max_dist)
+{
+	lt_bcres_t *br;
+	int i, j, l_oligo = strlen(oligo);
+	br = (lt_bcres_t*)calloc(1, sizeof(lt_bcres_t));
+	br->max_dist = max_dist;
+	for (i = 0; i < bi->n; ++i) {
+		int l = bi->len[i] + l_oligo;
+		uint64_t x = 0;
+		if (l > 32) {
+			if (lt_verbose >= 2)
+				fprintf(stderr, "[W::%s] barcode '%s' is too long to be rescued\n", __func__, bi->seq[i]);
+			continue;
+		}
+		for (j = 0; j < br->n_len && br->len[j] < l; ++j);
+		if (j == br->n_len || br->len[j] != l) { // a new length; keep len[] sorted
+			memmove(&br->len[j+1], &br->len[j], (br->n_len - j) * sizeof(int));
+			memmove(&br->h[j+1], &br->h[j], (br->n_len - j) * sizeof(khash_t(bcr)*));
+			br->len[j] = l, br->h[j] = kh_init(bcr), ++br->n_len;
+		}
+		for (l = 0; l < bi->len[i]; ++l) x = x<<2 | lt_nt4_table[(uint8_t)bi->seq[i][l]];
+		for (l = 0; l < l_oligo; ++l) x = x<<2 | lt_nt4_table[(uint8_t)oligo[l]];
+		lt_bcres_enum(br->h[j], br->len[j], x, 0, 0, max_dist, i);
+	}
+	for (j = 0; j < br->n_len; ++j) {
+		khint_t k;
+		for (k = 0; k != kh_end(br->h[j]); ++k)
+			if (kh_exist(br->h[j], k)) {
+				++br->n_var;
+				if ((kh_val(br->h[j], k)&0xffff) == LT_BCR_AMBI) ++br->n_ambi;
+			}
+	}
+	return br;
+}
+
+// match the 5'-end of s[0..l); return the barcode id, -1 if there is no inexact hit or -2 if ambiguous
+static int lt_bcres_get(const lt_bcres_t *br, int l, const char *s)
+{
+	int i, j, id = -1, min_d = br->max_dist + 1;
+	uint64_t x = 0;
+	for (i = j = 0; i < l && j < br->n_len; ++i) {
+		int c = lt_nt4_table[(uint8_t)s[i]];
+		if (c > 3) break; // no rescue across an N
+		x = x<<2 | c;
+		if (i + 1 == br->len[j]) {
+			khint_t k = kh_get(bcr, br->h[j], x);
+			if (k != kh_end(br->h[j])) {
+				int d = kh_val(br->h[j], k)>>16, y = kh_val(br->h[j], k)&0xffff;
+				if (d == 0) return -1; // an exact barcode the exact search has rejected
+				if (d < min_d) min_d = d, id = y == LT_BCR_AMBI? -2 : y;
+				else if (d == min_d && y != id) id = -2;
+			}
+			++j;
+		}
+	}
+	return id;
+}
+
+/**************
+ * Cell index *
+ **************/
+
+/* Barcode pairs "FWD-REV", one per line, with cell ids in the order of the list. A pair may show up as
+ * FWD+REV or REV+FWD in BC:Z, so both are keyed by 2 bits per base plus the length. The keys go to slots
+ * through a perfect hash built by hash-and-displace: keys are first hashed to buckets, and each bucket, the
+ * largest first, gets the smallest displacement that sends all its keys to free slots. A lookup is then two
+ * hashes and one comparison. A key shared by two pairs is kept with id -1. */
+
+#define LT_CELL_MAX_LEN 29 // max length of a concatenated barcode; 58 bits + the length in the top 6 bits
+
+typedef struct {
+	int n, bits, b_bits; // n cells; 1<<bits slots and 1<<b_bits buckets
+	char **name;
+	uint16_t *disp; // displacement of each bucket
+	uint64_t *key; // 0 for an empty slot
+	int32_t *id;
+} lt_cells_t;
+
+static inline uint64_t lt_cells_hash(uint64_t k, uint64_t d) // splitmix64 of _k_ with seed _d_
+{
+	k += (d + 1) * 0x9e3779b97f4a7c15ULL;
+	k = (k ^ (k >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	k = (k ^ (k >> 27)) * 0x94d049bb133111ebULL;
+	return k ^ (k >> 31);
+}
+
+#define lt_cells_bucket(c, k) (lt_cells_hash((k), 0) & ((1ULL<<(c)->b_bits) - 1))
+#define lt_cells_slot(c, k, d) (lt_cells_hash((k), (uint64_t)(d) + 1) >> (64 - (c)->bits))
+
+// key of s[0..l) followed by t[0..m); 0 if not A/C/G/T or too long
+static uint64_t lt_cells_key(int l, const char *s, int m, const char *t)
+{
+	uint64_t x = 0;
+	int i;
+	if (l + m == 0 || l + m > LT_CELL_MAX_LEN) return 0;
+	for (i = 0; i < l + m; ++i) {
+		int c = lt_nt4_table[(uint8_t)(i < l? s[i] : t[i - l])];
+		if (c > 3) return 0;
+		x = x<<2 | c;
+	}
+	return (uint64_t)(l + m) << 58 | x;
+}
+
+void lt_cells_destroy(lt_cells_t *c)
+{
+	int i;
+	if (c == 0) return;
+	for (i = 0; i < c->n; ++i) free(c->name[i]);
+	free(c->name); free(c->disp); free(c->key); free(c->id); free(c);
+}
+
+// place the n_keys keys, in the even elements of kid[] with ids in the odd ones; -1 on failure
+static int lt_cells_build(lt_cells_t *c, int n_keys, const uint64_t *kid)
+{
+	int i, j, n_b, *cnt, *ord, *pos, *bk;
+	uint64_t *slot;
+	for (c->b_bits = 0; 4<<c->b_bits < n_keys; ++c->b_bits);
+	n_b = 1<<c->b_bits;
+	cnt = (int*)calloc(n_b + 1, sizeof(int));
+	ord = (int*)malloc(n_b * sizeof(int));
+	pos = (int*)calloc(n_b, sizeof(int));
+	bk = (int*)malloc(n_keys * sizeof(int)); // key indices grouped by bucket: bucket b in bk[cnt[b],cnt[b+1])
+	slot = (uint64_t*)malloc(n_keys * sizeof(uint64_t));
+	for (i = 0; i < n_keys; ++i) ++cnt[lt_cells_bucket(c, kid[i<<1]) + 1];
+	for (i = 0; i < n_b; ++i) cnt[i+1] += cnt[i], ord[i] = i;
+	for (i = 0; i < n_keys; ++i) {
+		int b = lt_cells_bucket(c, kid[i<<1]);
+		bk[cnt[b] + pos[b]++] = i;
+	}
+	for (i = 1; i < n_b; ++i) // insertion sort by bucket size, largest first
+		for (j = i; j > 0 && cnt[ord[j]+1] - cnt[ord[j]] > cnt[ord[j-1]+1] - cnt[ord[j-1]]; --j) {
+			int t = ord[j];
+			ord[j] = ord[j-1], ord[j-1] = t;
+		}
+	c->disp = (uint16_t*)calloc(n_b, sizeof(uint16_t));
+	for (c->bits = 4; 1<<c->bits < n_keys + n_keys / 4; ++c->bits);
+	for (; c->bits < 24; ++c->bits) {
+		c->key = (uint64_t*)realloc(c->key, (1<<c->bits) * sizeof(uint64_t));
+		c->id = (int32_t*)realloc(c->id, (1<<c->bits) * sizeof(int32_t));
+		memset(c->key, 0, (1<<c->bits) * sizeof(uint64_t));
+		for (i = 0; i < n_b; ++i) {
+			int b = ord[i], st = cnt[b], en = cnt[b+1], d, k, l;
+			for (d = 0; d < 0x10000; ++d) {
+				for (k = st; k < en; ++k) {
+					slot[k] = lt_cells_slot(c, kid[bk[k]<<1], d);
+					if (c->key[slot[k]]) break;
+					for (l = st; l < k && slot[l] != slot[k]; ++l);
+					if (l < k) break;
+				}
+				if (k == en) break;
+			}
+			if (d == 0x10000) break;
+			c->disp[b] = d;
+			for (k = st; k < en; ++k)
+				c->key[slot[k]] = kid[bk[k]<<1], c->id[slot[k]] = (int32_t)kid[bk[k]<<1|1];
+		}
+		if (i == n_b) break;
+	}
+	free(cnt); free(ord); free(pos); free(bk); free(slot);
+	return c->bits < 24? 0 : -1;
+}
+
+lt_cells_t *lt_cells_load(const char *fn)
+{
+	FILE *fp;
+	char line[1024], *p, *q;
+	int i, l, n_keys = 0, m_keys = 0, n_shared = 0;
+	uint64_t *kid = 0;
+	lt_cells_t *c;
+	if ((fp = fopen(fn, "r")) == 0) return 0;
+	c = (lt_cells_t*)calloc(1, sizeof(lt_cells_t));
+	while (fgets(line, sizeof(line), fp)) {
+		uint64_t k[2];
+		for (p = line; *p && !isspace((uint8_t)*p); ++p);
+		*p = 0;
+		if (line[0] == 0) continue;
+		if ((q = strchr(line, '-')) == 0 || (k[0] = lt_cells_key(q - line, line, strlen(q + 1), q + 1)) == 0
+			|| (k[1] = lt_cells_key(strlen(q + 1), q + 1, q - line, line)) == 0) {
+			fprintf(stderr, "[E::%s] invalid barcode pair '%s'\n", __func__, line);
+			free(kid); fclose(fp); lt_cells_destroy(c);
+			return 0;
+		}
+		c->name = (char**)realloc(c->name, (c->n + 1) * sizeof(char*));
+		c->name[c->n] = strdup(line);
+		for (l = 0; l < 2; ++l) {
+			for (i = 0; i < n_keys; ++i)
+				if (kid[i<<1] == k[l]) break;
+			if (i < n_keys) { // FWD+REV of this pair, if FWD==REV, or a key of another pair
+				if (kid[i<<1|1] != (uint64_t)c->n && kid[i<<1|1] != (uint64_t)-1) kid[i<<1|1] = (uint64_t)-1, ++n_shared;
+				continue;
+			}
+			if (n_keys == m_keys) {
+				m_keys = m_keys? m_keys<<1 : 256;
+				kid = (uint64_t*)realloc(kid, m_keys * 2 * sizeof(uint64_t));
+			}
+			kid[n_keys<<1] = k[l], kid[n_keys<<1|1] = c->n;
+			++n_keys;
+		}
+		++c->n;
+	}
+	fclose(fp);
+	if (n_shared > 0 && lt_verbose >= 2)
+		fprintf(stderr, "[W::%s] %d concatenated barcodes are shared by different pairs and will not be assigned\n", __func__, n_shared);
+	if (c->n == 0 || lt_cells_build(c, n_keys, kid) < 0) {
+		free(kid); lt_cells_destroy(c);
+		return 0;
+	}
+	free(kid);
+	return c;
+}
+
+// cell id of a BC:Z string, or -1
+static inline int lt_cells_get(const lt_cells_t *c, const char *bc_cat)
+{
+	uint64_t k = lt_cells_key(strlen(bc_cat), bc_cat, 0, 0), j;
+	if (k == 0) return -1;
+	j = lt_cells_slot(c, k, c->disp[lt_cells_bucket(c, k)]);
+	return c->key[j] == k? c->id[j] : -1;
+}
+
+// write one @RG header line per cell, with the cell id as ID
+int lt_cells_write_rg(const lt_cells_t *c, const char *fn)
+{
+	FILE *fp;
+	int i;
+	if ((fp = fopen(fn, "w")) == 0) return -1;
+	for (i = 0; i < c->n; ++i)
+		fprintf(fp, "@RG\tID:%d\tSM:%s\tBC:%s\n", i, c->name[i], c->name[i]);
+	return fclose(fp);
+}
+
+/***************
+ * Chunk arena *
+ ***************/
+
+#define LT_ARENA_BLK_SIZE 0x400000 // 4MB
+
+typedef struct lt_ablk_s {
+	struct lt_ablk_s *next;
+	size_t l, m;
+	char *a;
+} lt_ablk_t;
+
+typedef struct { // a bump allocator; everything is released at once by lt_arena_destroy()
+	lt_ablk_t *blk;
+	int n_blks;
+	size_t n_alloc; // total bytes handed out
+} lt_arena_t;
+
+static void *lt_arena_alloc(lt_arena_t *ar, size_t size)
+{
+	lt_ablk_t *b = ar->blk;
+	void *p;
+	size = (size + 7) & ~(size_t)7;
+	if (b == 0 || b->l + size > b->m) {
+		size_t m = size > LT_ARENA_BLK_SIZE? size : LT_ARENA_BLK_SIZE;
+		b = (lt_ablk_t*)malloc(sizeof(lt_ablk_t) + m);
+		b->a = (char*)(b + 1);
+		b->l = 0, b->m = m;
+		b->next = ar->blk, ar->blk = b;
+		++ar->n_blks;
+	}
+	p = b->a + b->l;
+	b->l += size;
+	ar->n_alloc += size;
+	return p;
+}
+
+// copy _l_ bytes of _s_ into the arena and NULL terminate
+static inline char *lt_arena_strndup(lt_arena_t *ar, const char *s, size_t l)
+{
+	char *p = (char*)lt_arena_alloc(ar, l + 1);
+	memcpy(p, s, l);
+	p[l] = 0;
+	return p;
+}
+
+static inline size_t lt_arena_capacity(const lt_arena_t *ar)
+{
+	size_t m = 0;
+	lt_ablk_t *b;
+	for (b = ar->blk; b; b = b->next) m += b->m;
+	return m;
+}
+
+static void lt_arena_destroy(lt_arena_t *ar)
+{
+	lt_ablk_t *b, *next;
+	for (b = ar->blk; b; b = next) {
+		next = b->next;
+		free(b);
+	}
+	memset(ar, 0, sizeof(lt_arena_t));
+}
+
+/**********************
+ * Batch FASTQ reader *
+ **********************/
+
+#include <zlib.h>
+#include <pthread.h>
+#include "bgzf.h"
+
+#define LT_READ_BLK 0x100000 // read at least 1MB at a time
+#define LT_RA_DEPTH 32       // number of buffers queued by the read-ahead thread
+
+enum lt_inflate_e { LT_INFLATE_AUTO = 0, LT_INFLATE_SERIAL, LT_INFLATE_THREAD, LT_INFLATE_BGZF };
+static const char *lt_inflate_str[] = { "auto", "serial", "thread", "bgzf" };
+
+typedef struct {
+	uint32_t l_seq:31, dbl_bind:1;
+	enum lt_type_e type;
+	int olig_pos_f, olig_pos_r;
+	int bc_id_f, bc_id_r; // ids of the barcodes trimmed from the 5'-ends, or -1
+	int merge_pos_l, merge_pos_r; 
+	int cell; // cell id with -R, or -1
+	char *name, *seq, *qual, *bc_f, *bc_r, *bc_cat; // name/seq/qual point into the chunk buffer
+} bseq1_t;
+
+typedef struct { // gzread() on a dedicated thread, feeding a queue of LT_READ_BLK buffers
+	gzFile fp;
+	pthread_t tid;
+	pthread_mutex_t lock;
+	pthread_cond_t cv;
+	int head, n, eof, stop; // buffers buf[head], buf[head+1], ..., buf[head+n-1] are filled
+	int len[LT_RA_DEPTH];
+	char *buf[LT_RA_DEPTH];
+} lt_rahead_t;
+
+typedef struct { // a BGZF block: compressed address and start in the decompressed stream
+	int64_t c, u;
+} bseq_blk_t;
+
+typedef struct {
+	int inflate, n_threads; // inflate is one of lt_inflate_e
+	gzFile fp;       // for LT_INFLATE_SERIAL
+	lt_rahead_t *ra; // for LT_INFLATE_THREAD
+	BGZF *bgzf;      // for LT_INFLATE_BGZF
+	uint8_t *raw;    // raw BGZF blocks, each taking BGZF_MAX_BLOCK_SIZE bytes
+	int max_raw, n_raw, *raw_len, *raw_off;
+	kvec_t(bseq_blk_t) blk; // blocks read, from the one holding buf[pos]
+	int64_t skip; // bytes to drop from the first block after seeking to a virtual offset
+	int64_t end, end_u; // with --shard: virtual offset to stop at, or -1, and its position in the decompressed stream
+	int eof;
+	int64_t n_bytes; // number of decompressed bytes; starts at the offset seeked to for non-BGZF input
+	size_t pos, l, m; // buf[pos..l) has not been parsed
+	char *buf;
+} bseq_file_t;
+
+void kt_for(int n_threads, void (*func)(void*,long,int), void *data, long n);
+
+static void *ra_worker(void *data)
+{
+	lt_rahead_t *ra = (lt_rahead_t*)data;
+	for (;;) {
+		int i, ret;
+		pthread_mutex_lock(&ra->lock);
+		while (ra->n == LT_RA_DEPTH && !ra->stop)
+			pthread_cond_wait(&ra->cv, &ra->lock);
+		i = (ra->head + ra->n) % LT_RA_DEPTH;
+		pthread_mutex_unlock(&ra->lock);
+		if (ra->stop) break;
+		ret = gzread(ra->fp, ra->buf[i], LT_READ_BLK); // buf[i] is not visible to the consumer
+		pthread_mutex_lock(&ra->lock);
+		if (ret > 0) ra->len[i] = ret, ++ra->n;
+		else ra->eof = ret < 0? -1 : 1;
+		pthread_cond_broadcast(&ra->cv);
+		pthread_mutex_unlock(&ra->lock);
+		if (ret <= 0) break;
+	}
+	return 0;
+}
+
+static lt_rahead_t *ra_init(gzFile fp)
+{
+	lt_rahead_t *ra;
+	int i;
+	ra = (lt_rahead_t*)calloc(1, sizeof(lt_rahead_t));
+	ra->fp = fp;
+	for (i = 0; i < LT_RA_DEPTH; ++i)
+		ra->buf[i] = (char*)malloc(LT_READ_BLK);
+	pthread_mutex_init(&ra->lock, 0);
+	pthread_cond_init(&ra->cv, 0);
+	pthread_create(&ra->tid, 0, ra_worker, ra);
+	return ra;
+}
+
+// move the next queued buffer to _dst_ which has room for LT_READ_BLK bytes; return its length, 0 on EOF or -1 on error
+static int ra_read(lt_rahead_t *ra, char *dst)
+{
+	int ret;
+	pthread_mutex_lock(&ra->lock);
+	while (ra->n == 0 && ra->eof == 0)
+		pthread_cond_wait(&ra->cv, &ra->lock);
+	if (ra->n > 0) {
+		ret = ra->len[ra->head];
+		memcpy(dst, ra->buf[ra->head], ret);
+		ra->head = (ra->head + 1) % LT_RA_DEPTH, --ra->n;
+		pthread_cond_broadcast(&ra->cv);
+	} else ret = ra->eof < 0? -1 : 0;
+	pthread_mutex_unlock(&ra->lock);
+	return ret;
+}
+
+static void ra_destroy(lt_rahead_t *ra)
+{
+	int i;
+	pthread_mutex_lock(&ra->lock);
+	ra->stop = 1;
+	pthread_cond_broadcast(&ra->cv);
+	pthread_mutex_unlock(&ra->lock);
+	pthread_join(ra->tid, 0);
+	pthread_mutex_destroy(&ra->lock);
+	pthread_cond_destroy(&ra->cv);
+	gzclose(ra->fp);
+	for (i = 0; i < LT_RA_DEPTH; ++i) free(ra->buf[i]);
+	free(ra);
+}
+
+// open _fn_ and start at _off_: a virtual offset for BGZF, or an offset in the decompressed stream otherwise
+bseq_file_t *bseq_open(const char *fn, int inflate, int n_threads, int64_t off)
+{
+	bseq_file_t *f;
+	int is_stdin = (strcmp(fn, "-") == 0);
+	if (inflate == LT_INFLATE_AUTO)
+		inflate = !is_stdin && bgzf_is_bgzf(fn)? LT_INFLATE_BGZF : LT_INFLATE_THREAD;
+	f = (bseq_file_t*)calloc(1, sizeof(bseq_file_t));
+	f->inflate = inflate;
+	f->n_threads = n_threads > 0? n_threads : 1;
+	f->end = -1, f->end_u = INT64_MAX;
+	if (inflate == LT_INFLATE_BGZF) {
+		if (!is_stdin && !bgzf_is_bgzf(fn)) {
+			fprintf(stderr, "[E::%s] file '%s' is not BGZF-compressed\n", __func__, fn);
+			free(f);
+			return 0;
+		}
+		f->bgzf = is_stdin? bgzf_dopen(fileno(stdin), "r") : bgzf_open(fn, "r");
+		if (f->bgzf == 0) {
+			free(f);
+			return 0;
+		}
+		if (off > 0 && bgzf_seek(f->bgzf, off, SEEK_SET) < 0) {
+			fprintf(stderr, "[E::%s] failed to seek in '%s'\n", __func__, fn);
+			bgzf_close(f->bgzf);
+			free(f);
+			return 0;
+		}
+		f->skip = off & 0xffff;
+		f->max_raw = f->n_threads * 4 > 16? f->n_threads * 4 : 16;
+		f->raw = (uint8_t*)malloc((size_t)f->max_raw * BGZF_MAX_BLOCK_SIZE);
+		f->raw_len = (int*)calloc(f->max_raw * 2, sizeof(int));
+		f->raw_off = f->raw_len + f->max_raw;
+	} else {
+		gzFile fp;
+		fp = is_stdin? gzdopen(fileno(stdin), "r") : gzopen(fn, "r");
+		if (fp == 0) {
+			free(f);
+			return 0;
+		}
+		if (off > 0 && gzseek(fp, off, SEEK_SET) != off) { // gzip is inflated up to _off_
+			fprintf(stderr, "[E::%s] failed to seek in '%s'\n", __func__, fn);
+			gzclose(fp);
+			free(f);
+			return 0;
+		}
+		f->n_bytes = off;
+		if (inflate == LT_INFLATE_THREAD) f->ra = ra_init(fp);
+		else f->fp = fp;
+	}
+	return f;
+}
+
+void bseq_close(bseq_file_t *f)
+{
+	if (f->ra) ra_destroy(f->ra);
+	if (f->fp) gzclose(f->fp);
+	if (f->bgzf) bgzf_close(f->bgzf);
+	free(f->raw); free(f->raw_len);
+	kv_destroy(f->blk);
+	free(f->buf);
+	free(f);
+}
+
+static void bgzf_inflate_worker(void *data, long i, int tid)
+{
+	bseq_file_t *f = (bseq_file_t*)data;
+	int ret;
+	ret = bgzf_inflate_raw(f->raw + i * BGZF_MAX_BLOCK_SIZE, f->raw_len[i], f->buf + f->l + f->raw_off[i]);
+	f->raw_len[i] = ret; // keep the uncompressed length for a sanity check
+}
+
+// read up to LT_READ_BLK bytes worth of BGZF blocks and inflate them in parallel to buf[l..m)
+static int bseq_fill_bgzf(bseq_file_t *f)
+{
+	int i, ret, n = 0, off = 0;
+	while (n < f->max_raw && off < LT_READ_BLK) {
+		uint8_t *b = f->raw + n * BGZF_MAX_BLOCK_SIZE;
+		if ((ret = bgzf_read_raw(f->bgzf, b)) <= 0) {
+			if (ret < 0) return -1;
+			break;
+		}
+		f->raw_len[n] = ret, f->raw_off[n] = off;
+		{
+			bseq_blk_t p = { f->bgzf->block_address, f->n_bytes + off };
+			kv_push(bseq_blk_t, f->blk, p);
+			if (f->end >= 0 && p.c == f->end>>16) f->end_u = p.u + (f->end & 0xffff);
+		}
+		off += b[ret-4] | b[ret-3]<<8 | b[ret-2]<<16 | (uint32_t)b[ret-1]<<24; // ISIZE in the footer
+		++n;
+	}
+	if (f->m - f->l <= (size_t)off) {
+		f->m = f->l + off + 1;
+		f->m += f->m >> 1;
+		f->buf = (char*)realloc(f->buf, f->m);
+	}
+	if (n > 1) kt_for(f->n_threads < n? f->n_threads : n, bgzf_inflate_worker, f, n);
+	else if (n == 1) bgzf_inflate_worker(f, 0, 0);
+	for (i = 0; i < n; ++i)
+		if (f->raw_len[i] < 0 || f->raw_off[i] + f->raw_len[i] != (i == n - 1? off : f->raw_off[i+1]))
+			return -1;
+	return off;
+}
+
+// append more data to f->buf, enlarging it if necessary; return the number of bytes read
+static int bseq_fill(bseq_file_t *f)
+{
+	int ret;
+	if (f->m - f->l <= LT_READ_BLK) {
+		f->m = f->l + LT_READ_BLK + 1;
+		f->m += f->m >> 1;
+		f->buf = (char*)realloc(f->buf, f->m);
+	}
+	if (f->inflate == LT_INFLATE_BGZF) ret = bseq_fill_bgzf(f);
+	else if (f->inflate == LT_INFLATE_THREAD) ret = ra_read(f->ra, f->buf + f->l);
+	else ret = gzread(f->fp, f->buf + f->l, LT_READ_BLK); // leave room for a trailing newline
+	if (ret < 0) {
+		fprintf(stderr, "[E::%s] failed to read the input\n", __func__);
+		exit(1);
+	}
+	if (ret == 0) {
+		f->eof = 1;
+		if (f->l > f->pos && f->buf[f->l - 1] != '\n') // the last line is not terminated
+			f->buf[f->l++] = '\n';
+	}
+	f->l += ret;
+	f->n_bytes += ret;
+	if (f->skip) f->pos += f->skip, f->skip = 0; // the first block after bgzf_seek() holds at least _skip_ bytes
+	return ret;
+}
+
+// parse one 4-line FASTQ record in place; return 1 on success, 0 if buf[pos..l) has no complete record
+static int bseq_parse1(bseq_file_t *f, bseq1_t *s)
+{
+	char *p, *end = f->buf + f->l, *line[4], *eol[4];
+	int i;
+	for (p = f->buf + f->pos; p < end && (*p == '\n' || *p == '\r'); ++p); // skip empty lines
+	f->pos = p - f->buf;
+	for (i = 0; i < 4; ++i) {
+		line[i] = p;
+		if ((eol[i] = (char*)memchr(p, '\n', end - p)) == 0) return 0;
+		p = eol[i] + 1;
+		if (eol[i] > line[i] && eol[i][-1] == '\r') --eol[i];
+	}
+	if (*line[0] != '@' || *line[2] != '+' || eol[1] - line[1] != eol[3] - line[3]) {
+		fprintf(stderr, "[E::%s] malformed FASTQ record at '%.*s'; only 4-line FASTQ is supported\n", __func__,
+				(int)(eol[0] - line[0]), line[0]);
+		exit(1);
+	}
+	for (s->name = ++line[0]; line[0] < eol[0] && *line[0] != ' ' && *line[0] != '\t'; ++line[0]);
+	*line[0] = 0;
+	s->seq = line[1], s->qual = line[3];
+	s->l_seq = eol[1] - line[1];
+	*eol[1] = *eol[3] = 0;
+	s->bc_f = s->bc_r = s->bc_cat = 0;
+	s->dbl_bind = 0;
+	s->type = LT_UNKNOWN;
+	s->olig_pos_f = s->olig_pos_r = 0;
+	s->merge_pos_l = s->merge_pos_r = 0;
+	s->cell = -1;
+	f->pos = p - f->buf;
+	return 1;
+}
+
+// read the next record from _f_; if f->buf is moved, rebase the _n_ records r[0], r[stride], ... that point into it
+static int bseq_next(bseq_file_t *f, bseq1_t *s, bseq1_t *r, int n, int stride)
+{
+	for (;;) {
+		uintptr_t old = (uintptr_t)f->buf;
+		int i;
+		if (f->n_bytes - (int64_t)(f->l - f->pos) >= f->end_u) return 0; // the end of a shard
+		if (bseq_parse1(f, s)) break;
+		if (f->eof) {
+			if (f->pos < f->l) {
+				fprintf(stderr, "[E::%s] truncated FASTQ record at the end of the input\n", __func__);
+				exit(1);
+			}
+			return 0;
+		}
+		bseq_fill(f);
+		if ((uintptr_t)f->buf != old) {
+			intptr_t d = (uintptr_t)f->buf - old;
+			for (i = 0; i < n; i += stride) {
+				r[i].name = (char*)((uintptr_t)r[i].name + d);
+				r[i].seq  = (char*)((uintptr_t)r[i].seq  + d);
+				r[i].qual = (char*)((uintptr_t)r[i].qual + d);
+			}
+		}
+	}
+	return 1;
+}
+
+// position of the first unparsed byte, for bseq_open(); it also forgets the BGZF blocks already parsed
+static int64_t bseq_tell(bseq_file_t *f)
+{
+	int64_t u = f->n_bytes - (int64_t)(f->l - f->pos);
+	size_t i;
+	if (f->inflate != LT_INFLATE_BGZF) return u;
+	for (i = 0; i + 1 < f->blk.n && f->blk.a[i+1].u <= u; ++i);
+	if (i > 0) {
+		memmove(f->blk.a, f->blk.a + i, (f->blk.n - i) * sizeof(bseq_blk_t));
+		f->blk.n -= i;
+	}
+	return f->blk.n? f->blk.a[0].c<<16 | (u - f->blk.a[0].u) : 0;
+}
+
+// hand the parsed part of f->buf over to the caller and move the unparsed tail to a new buffer
+static char *bseq_detach(bseq_file_t *f)
+{
+	char *buf = f->buf;
+	f->l -= f->pos;
+	f->buf = (char*)malloc(f->m);
+	memcpy(f->buf, buf + f->pos, f->l);
+	f->pos = 0;
+	return buf;
+}
+
+// read an interleaved stream from f1, or read pairs from f1 and f2 in lockstep if f2 is not NULL. Records
+// are parsed in place: the buffers holding them are returned in buf[] and are owned by the caller.
+bseq1_t *bseq_read(bseq_file_t *f1, bseq_file_t *f2, int chunk_size, int *n_, char *buf[2])
+{
+	int size = 0, m, n;
+	bseq1_t *seqs;
+	m = n = 0; seqs = 0;
+	for (;;) {
+		if (n + 1 >= m) {
+			m = m? m<<1 : 256;
+			seqs = (bseq1_t*)realloc(seqs, m * sizeof(bseq1_t));
+		}
+		if (!bseq_next(f1, &seqs[n], seqs, n, f2? 2 : 1)) break;
+		if (f2 && !bseq_next(f2, &seqs[n+1], seqs + 1, n, 2)) { // the 2nd file has fewer reads
+			fprintf(stderr, "[W::%s] the 2nd file has fewer sequences.\n", __func__);
+			break;
+		}
+		size += seqs[n++].l_seq;
+		if (f2) size += seqs[n++].l_seq;
+		if (size >= chunk_size && (n&1) == 0) break;
+	}
+	if (size == 0 && f2 && f1->end < 0 && bseq_next(f2, &seqs[0], 0, 0, 2)) // test if the 2nd file is finished
+		fprintf(stderr, "[W::%s] the 1st file has fewer sequences.\n", __func__);
+	buf[0] = bseq_detach(f1);
+	buf[1] = f2? bseq_detach(f2) : 0;
+	if (n == 0) {
+		free(seqs); free(buf[0]); free(buf[1]);
+		seqs = 0, buf[0] = buf[1] = 0;
+	}
+	*n_ = n;
+	return seqs;
+}
+
+/************
+ * Sharding *
+ ************/
+
+/* With --shard i/N, the compressed size of the first BGZF input is cut into N equal ranges and shard i
+ * processes the pairs starting in the i-th. A boundary moves forward to the next BGZF block, recognized by
+ * its header and the header of the block after it, then to the next 4-line record following a newline and,
+ * for interleaved input, to the next first read of a pair. The second file is searched around the same
+ * relative offset for the read name at the boundary. The two shards sharing a boundary locate it the same
+ * way, so the outputs of the N shards concatenate to the output of a single process. */
+
+#include <sys/stat.h>
+
+#define LT_SHARD_MARGIN 0x400000 // start the search in the second file this many compressed bytes early
+
+static inline int lt_bgzf_header(const uint8_t *b) // return the block size, or 0 if _b_ is not a BGZF header
+{
+	if (b[0] != 31 || b[1] != 139 || b[2] != 8 || !(b[3]&4) || b[10] != 6 || b[11] != 0 || b[12] != 'B' || b[13] != 'C' || b[14] != 2 || b[15] != 0)
+		return 0;
+	return (b[16] | b[17]<<8) + 1;
+}
+
+// compressed address of the first BGZF block at or after _off_ in a file of _size_ bytes, or _size_ if there is none
+static int64_t lt_bgzf_sync(const char *fn, int64_t off, int64_t size)
+{
+	FILE *fp;
+	uint8_t *buf;
+	int64_t ret = size;
+	int i, n;
+	if ((fp = fopen(fn, "rb")) == 0) return -1;
+	buf = (uint8_t*)malloc(2 * BGZF_MAX_BLOCK_SIZE + 18); // a block starts within BGZF_MAX_BLOCK_SIZE bytes, and so does the next
+	if (fseeko(fp, off, SEEK_SET) < 0) n = 0;
+	else n = fread(buf, 1, 2 * BGZF_MAX_BLOCK_SIZE + 18, fp);
+	for (i = 0; i + 18 <= n; ++i) {
+		int l = lt_bgzf_header(&buf[i]);
+		if (l > 0 && (off + i + l == size || (i + l + 18 <= n && lt_bgzf_header(&buf[i + l])))) {
+			ret = off + i;
+			break;
+		}
+	}
+	free(buf);
+	fclose(fp);
+	return ret;
+}
+
+// if s[0..l) starts with a 4-line record, return its length and set *l_name to the length of the read name
+// without "/1" or "/2"; return 0 if more data is needed, or -1 if it is not a record
+static long lt_fq_rec(const char *s, long l, int *l_name)
+{
+	const char *p = s, *end = s + l, *line[4], *eol[4];
+	int i;
+	for (i = 0; i < 4; ++i) {
+		line[i] = p;
+		if ((eol[i] = (const char*)memchr(p, '\n', end - p)) == 0) return 0;
+		p = eol[i] + 1;
+	}
+	if (*line[0] != '@' || *line[2] != '+' || eol[1] - line[1] != eol[3] - line[3]) return -1;
+	for (p = line[0] + 1; p < eol[0] && *p != ' ' && *p != '\t' && *p != '\r'; ++p);
+	if (p - line[0] > 3 && p[-2] == '/' && (p[-1] == '1' || p[-1] == '2')) p -= 2;
+	*l_name = p - line[0] - 1;
+	return eol[3] + 1 - s;
+}
+
+// move f->pos to the first record after a newline that is followed by a record or the end of the input and,
+// with _interleaved_, has the same name as that record; return 0 if there is no such record
+static int lt_shard_sync(bseq_file_t *f, int interleaved)
+{
+	int at_line = 0; // whether buf[pos] starts a line
+	for (;;) {
+		char *s = f->buf + f->pos;
+		long n = f->l - f->pos, r1, r2 = 0;
+		int n1 = 0, n2 = 0;
+		if (!at_line) {
+			char *nl = (char*)memchr(s, '\n', n);
+			if (nl) f->pos += nl + 1 - s, at_line = 1;
+			else if (f->eof) return 0;
+			else f->pos = f->l, bseq_fill(f);
+			continue;
+		}
+		r1 = lt_fq_rec(s, n, &n1);
+		if (r1 > 0) r2 = lt_fq_rec(s + r1, n - r1, &n2);
+		if ((r1 == 0 || r2 == 0) && !f->eof) {
+			bseq_fill(f);
+			continue;
+		}
+		if (r1 <= 0) {
+			if (r1 == 0) return 0;
+			at_line = 0;
+		} else if (r2 < 0) at_line = 0;
+		else if (!interleaved || (r2 > 0 && n1 == n2 && strncmp(s + 1, s + r1 + 1, n1) == 0)) return 1;
+		else f->pos += r1; // s is the second read of a pair
+	}
+}
+
+// open BGZF _fn_ at the first record after compressed offset _x_ as by lt_shard_sync(), to be read up to virtual
+// offset _end_ (-1 for the end of the file); *found is set to 0 if there is no such record
+static bseq_file_t *lt_shard_open(const char *fn, int64_t x, int64_t end, int64_t size, int interleaved, int n_threads, int *found)
+{
+	bseq_file_t *f;
+	int64_t c = x > 0? lt_bgzf_sync(fn, x, size) : 0;
+	*found = 0;
+	if (c < 0 || (f = bseq_open(fn, LT_INFLATE_BGZF, n_threads, c<<16)) == 0) return 0;
+	f->end = end; // before reading any block
+	if (x == 0) *found = 1;
+	else if (c < size) *found = lt_shard_sync(f, interleaved);
+	if (!*found) f->pos = f->l;
+	return f;
+}
+
+// move f->pos to the record named _name_ and return 1, or return 0 if it is not found before compressed offset _en_
+static int lt_shard_find(bseq_file_t *f, const char *name, int l_name, int64_t en)
+{
+	for (;;) {
+		int n1;
+		long r = lt_fq_rec(f->buf + f->pos, f->l - f->pos, &n1);
+		if (r < 0) return 0;
+		if (r == 0) {
+			if (f->eof || bseq_tell(f)>>16 > en) return 0;
+			if (f->pos > 4 * LT_READ_BLK) free(bseq_detach(f)); // keep the buffer small
+			bseq_fill(f);
+			continue;
+		}
+		if (n1 == l_name && strncmp(f->buf + f->pos + 1, name, l_name) == 0) return 1;
+		f->pos += r;
+	}
+}
+
+// open _fn1_ and _fn2_ (NULL for interleaved input) for shard _i_ of _n_; return -1 on errors
+static int lt_shard_init(const char *fn1, const char *fn2, int i, int n, int n_threads, bseq_file_t **f1, bseq_file_t **f2)
+{
+	struct stat st1, st2;
+	bseq_file_t *f = 0;
+	int64_t end = -1, x, margin;
+	int found, l_name;
+	char *name;
+	*f1 = *f2 = 0;
+	if (!bgzf_is_bgzf(fn1) || (fn2 && !bgzf_is_bgzf(fn2))) {
+		fprintf(stderr, "[E::%s] --shard requires BGZF-compressed input files\n", __func__);
+		return -1;
+	}
+	if (stat(fn1, &st1) != 0 || (fn2 && stat(fn2, &st2) != 0)) return -1;
+	if (i + 1 < n) { // where the next shard starts
+		if ((f = lt_shard_open(fn1, st1.st_size * (i + 1) / n, -1, st1.st_size, !fn2, 1, &found)) == 0) return -1;
+		if (found) end = bseq_tell(f);
+		bseq_close(f);
+	}
+	x = st1.st_size * i / n;
+	if ((*f1 = lt_shard_open(fn1, x, end, st1.st_size, !fn2, n_threads, &found)) == 0) return -1;
+	if (fn2 == 0) return 0;
+	if (!found || x == 0) // no pairs in this shard, or the start of the file
+		return (*f2 = bseq_open(fn2, LT_INFLATE_BGZF, n_threads, 0)) == 0? -1 : 0;
+	lt_fq_rec((*f1)->buf + (*f1)->pos, (*f1)->l - (*f1)->pos, &l_name);
+	name = strndup((*f1)->buf + (*f1)->pos + 1, l_name);
+	x = (bseq_tell(*f1)>>16) * st2.st_size / st1.st_size; // about the same relative offset
+	for (margin = LT_SHARD_MARGIN;; margin <<= 2) { // widen the search until the name is found
+		int64_t st = x > margin? x - margin : 0;
+		if ((f = lt_shard_open(fn2, st, -1, st2.st_size, 0, n_threads, &found)) == 0) break;
+		if (found && lt_shard_find(f, name, l_name, st == 0? INT64_MAX : x + margin)) break;
+		bseq_close(f), f = 0;
+		if (st == 0) break;
+	}
+	if (f == 0) fprintf(stderr, "[E::%s] failed to find read '%s' in '%s'\n", __func__, name, fn2);
+	*f2 = f;
+	free(name);
+	return f? 0 : -1;
+}
+
+/*****************
+ * Memory budget *
+ *****************/
+
+/* Bytes held by the chunks in the pipeline: the reader charges the input buffers and records of a chunk,
+ * processing charges the arenas and output strings, and the chunk is released once written. With a
+ * budget, the reader waits before a new chunk while the chunks in flight plus the largest chunk so far
+ * would exceed it. There is always at least one chunk in flight, so the pipeline cannot stall. */
+
+#define LT_MEM_PER_BASE 8 // estimated bytes a chunk holds per input base, on top of lt_mem_fixed()
+#define lt_mem_fixed(opt) ((int64_t)(opt)->n_threads * LT_ARENA_BLK_SIZE + 4 * LT_READ_BLK) // arena blocks and slack in the input buffers
+
+typedef struct {
+	int64_t budget; // 0 for unlimited
+	int64_t used, peak, max_chunk;
+	int64_t n_blocked;
+	double t_blocked;
+	pthread_mutex_t lock;
+	pthread_cond_t cv;
+} lt_mem_t;
+
+// parse a size like 500M or 4g; 0 on errors
+static int64_t lt_parse_size(const char *str)
+{
+	double x;
+	char *p;
+	x = strtod(str, &p);
+	if (*p == 'G' || *p == 'g') x *= 1024. * 1024. * 1024., ++p;
+	else if (*p == 'M' || *p == 'm') x *= 1024. * 1024., ++p;
+	else if (*p == 'K' || *p == 'k') x *= 1024., ++p;
+	return *p == 0 && x > 0.? (int64_t)(x + .499) : 0;
+}
+
+static void lt_mem_init(lt_mem_t *m, int64_t budget, const lt_opt_t *opt)
+{
+	memset(m, 0, sizeof(lt_mem_t));
+	m->budget = budget;
+	m->max_chunk = (int64_t)opt->chunk_size * LT_MEM_PER_BASE + lt_mem_fixed(opt);
+	pthread_mutex_init(&m->lock, 0);
+	pthread_cond_init(&m->cv, 0);
+}
+
+static void lt_mem_destroy(lt_mem_t *m)
+{
+	pthread_mutex_destroy(&m->lock);
+	pthread_cond_destroy(&m->cv);
+}
+
+// block until another chunk fits in the budget; return 1 if it had to wait
+static int lt_mem_wait(lt_mem_t *m)
+{
+	int blocked = 0;
+	pthread_mutex_lock(&m->lock);
+	while (m->budget > 0 && m->used > 0 && m->used + m->max_chunk > m->budget) {
+		blocked = 1;
+		pthread_cond_wait(&m->cv, &m->lock);
+	}
+	m->n_blocked += blocked;
+	pthread_mutex_unlock(&m->lock);
+	return blocked;
+}
+
+static void lt_mem_charge(lt_mem_t *m, int64_t size)
+{
+	pthread_mutex_lock(&m->lock);
+	m->used += size;
+	if (m->used > m->peak) m->peak = m->used;
+	pthread_mutex_unlock(&m->lock);
+}
+
+// release a written chunk that has been charged _size_ bytes in total
+static void lt_mem_release(lt_mem_t *m, int64_t size)
+{
+	pthread_mutex_lock(&m->lock);
+	m->used -= size;
+	if (size > m->max_chunk) m->max_chunk = size;
+	pthread_cond_broadcast(&m->cv);
+	pthread_mutex_unlock(&m->lock);
+}
+
+/* Size chunks and the in-flight depth to _budget_: at most opt->n_inflight chunks of up to LT_MAX_CHUNK
+ * bases, or fewer in flight if chunks would drop below LT_MIN_CHUNK bases. */
+#define LT_MIN_CHUNK 1000000
+#define LT_MAX_CHUNK 50000000
+
+static void lt_mem_fit(lt_opt_t *opt, int64_t budget)
+{
+	int64_t c;
+	for (;;) {
+		c = (budget / opt->n_inflight - lt_mem_fixed(opt)) / LT_MEM_PER_BASE;
+		if (c >= LT_MIN_CHUNK || opt->n_inflight == 2) break;
+		--opt->n_inflight;
+	}
+	opt->chunk_size = c < LT_MIN_CHUNK? LT_MIN_CHUNK : c > LT_MAX_CHUNK? LT_MAX_CHUNK : c;
+}
+
+/******************
+ * Run statistics *
+ ******************/
+
+#include <time.h>
+#include <sys/resource.h>
+
+enum lt_sub_e { LT_SUB_NTRIM = 0, LT_SUB_ADAP, LT_SUB_BC, LT_SUB_MERGE, LT_SUB_FORMAT, LT_N_SUB };
+static const char *lt_sub_str[] = { "ntrim", "adapter", "barcode", "merge", "format" };
+
+enum lt_step_e { LT_STEP_READ = 0, LT_STEP_PROC, LT_STEP_OUT, LT_N_STEPS }; // kt_pipeline() steps
+static const char *lt_step_str[] = { "read", "process", "output" };
+
+static const struct { int type; const char *name; } lt_type_str[] = {
+	{ LT_UNKNOWN, "unknown" }, { LT_AMBI_BASE, "ambi_base" }, { LT_SHORT_SEQ, "short_seq" },
+	{ LT_SHORT_PE, "short_pe" }, { LT_SHORT_PE_SWAP, "short_pe_swap" }, { LT_MERGE_COMPLETE, "merge_complete" },
+	{ LT_MERGE_PARTIAL, "merge_partial" }, { LT_MERGE_COMPLETE_FH, "merge_complete_fh" }, { LT_MERGE_COMPLETE_RH, "merge_complete_rh" },
+	{ LT_MERGE_COMPLETE_CH, "merge_complete_ch" }, { LT_MERGE_AMBIGUOUS, "merge_ambiguous" }, { LT_NO_MERGE, "no_merge" },
+	{ -1, 0 }
+};
+
+typedef struct {
+	int64_t n_pairs, n_bases_in, n_bases_out, n_bases_uout;
+	int64_t n_type[LT_NO_MERGE+1], n_utype[LT_NO_MERGE+1]; // pairs per lt_type_e in the main and the -U output
+	int64_t n_adap[2]; // reads with an adapter trimmed or masked
+	int64_t *n_bc;     // n_bc[k*n+i]: times barcode i was trimmed from the 5'-end of read k+1, rescues included
+	int64_t n_rescue[2], n_rescue_ambi[2]; // reads with a barcode rescued by -r, or with an ambiguous rescue
+	int64_t n_cell; // pairs assigned to a cell with -R
+	int64_t n_nobc; // pairs without a barcode at both ends; dropped with --require-bc
+	double t_sub[LT_N_SUB]; // seconds spent in the lt_process() sub-stages and in formatting
+	double t_real[LT_N_STEPS], t_cpu[LT_N_STEPS];
+} lt_stats_t;
+
+static inline double lt_realtime(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline double lt_thread_cputime(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void lt_stats_init(lt_stats_t *st, int n_bc)
+{
+	memset(st, 0, sizeof(lt_stats_t));
+	st->n_bc = (int64_t*)calloc(n_bc * 2, sizeof(int64_t));
+}
+
+// add _b_ to _a_; both must have been initialized with the same _n_bc_
+static void lt_stats_add(lt_stats_t *a, const lt_stats_t *b, int n_bc)
+{
+	int i;
+	a->n_pairs += b->n_pairs, a->n_bases_in += b->n_bases_in;
+	a->n_bases_out += b->n_bases_out, a->n_bases_uout += b->n_bases_uout;
+	for (i = 0; i <= LT_NO_MERGE; ++i)
+		a->n_type[i] += b->n_type[i], a->n_utype[i] += b->n_utype[i];
+	for (i = 0; i < 2; ++i) {
+		a->n_adap[i] += b->n_adap[i];
+		a->n_rescue[i] += b->n_rescue[i], a->n_rescue_ambi[i] += b->n_rescue_ambi[i];
+	}
+	a->n_cell += b->n_cell, a->n_nobc += b->n_nobc;
+	for (i = 0; i < n_bc * 2; ++i) a->n_bc[i] += b->n_bc[i];
+	for (i = 0; i < LT_N_SUB; ++i) a->t_sub[i] += b->t_sub[i];
+	for (i = 0; i < LT_N_STEPS; ++i)
+		a->t_real[i] += b->t_real[i], a->t_cpu[i] += b->t_cpu[i];
+}
+
+static inline double lt_frac(int64_t a, int64_t b) { return b? (double)a / b : 0.0; }
+
+static void lt_stats_print_types(FILE *fp, const int64_t *n_type, int64_t n_pairs)
+{
+	int i;
+	fprintf(fp, "{");
+	for (i = 0; lt_type_str[i].name; ++i)
+		fprintf(fp, "%s\n      \"%s\": {\"pairs\": %lld, \"rate\": %.6f}", i? "," : "", lt_type_str[i].name,
+				(long long)n_type[lt_type_str[i].type], lt_frac(n_type[lt_type_str[i].type], n_pairs));
+	fprintf(fp, "\n    }");
+}
+
+// write _st_ as JSON to _fn_, through a temporary file so that readers never see a partial report
+static int lt_stats_write(const char *fn, const lt_stats_t *st, const lt_bcidx_t *bi, int has_u, int64_t n_chunks, int done, double t_start, const double *wait, const lt_mem_t *mem, int n_cells)
+{
+	FILE *fp;
+	char *tmp;
+	int i, k, ret;
+	struct rusage r;
+	tmp = (char*)alloca(strlen(fn) + 5);
+	strcat(strcpy(tmp, fn), ".tmp");
+	if ((fp = fopen(tmp, "w")) == 0) return -1;
+	getrusage(RUSAGE_SELF, &r);
+	fprintf(fp, "{\n  \"done\": %s,\n  \"chunks\": %lld,\n  \"pairs\": %lld,\n", done? "true" : "false", (long long)n_chunks, (long long)st->n_pairs);
+	fprintf(fp, "  \"bases\": {\"in\": %lld, \"out\": %lld", (long long)st->n_bases_in, (long long)st->n_bases_out);
+	if (has_u) fprintf(fp, ", \"unmerged_out\": %lld", (long long)st->n_bases_uout);
+	fprintf(fp, "},\n  \"types\": {\n    \"output\": ");
+	lt_stats_print_types(fp, st->n_type, st->n_pairs);
+	if (has_u) {
+		fprintf(fp, ",\n    \"unmerged\": ");
+		lt_stats_print_types(fp, st->n_utype, st->n_pairs);
+	}
+	fprintf(fp, "\n  },\n  \"adapter\": {\"read1\": {\"trimmed\": %lld, \"rate\": %.6f}, \"read2\": {\"trimmed\": %lld, \"rate\": %.6f}},\n",
+			(long long)st->n_adap[0], lt_frac(st->n_adap[0], st->n_pairs), (long long)st->n_adap[1], lt_frac(st->n_adap[1], st->n_pairs));
+	fprintf(fp, "  \"barcode_rescue\": {");
+	for (k = 0; k < 2; ++k)
+		fprintf(fp, "%s\"read%d\": {\"rescued\": %lld, \"ambiguous\": %lld}", k? ", " : "", k + 1, (long long)st->n_rescue[k], (long long)st->n_rescue_ambi[k]);
+	fprintf(fp, "},\n");
+	fprintf(fp, "  \"no_barcode\": {\"pairs\": %lld, \"rate\": %.6f},\n", (long long)st->n_nobc, lt_frac(st->n_nobc, st->n_pairs));
+	if (n_cells > 0)
+		fprintf(fp, "  \"cells\": {\"n\": %d, \"assigned\": %lld, \"rate\": %.6f},\n", n_cells, (long long)st->n_cell, lt_frac(st->n_cell, st->n_pairs));
+	fprintf(fp, "  \"barcodes\": [");
+	for (i = 0; i < bi->n; ++i) {
+		fprintf(fp, "%s\n    {\"seq\": \"%s\"", i? "," : "", bi->seq[i]);
+		for (k = 0; k < 2; ++k)
+			fprintf(fp, ", \"read%d\": {\"trimmed\": %lld, \"rate\": %.6f}", k + 1, (long long)st->n_bc[k*bi->n+i], lt_frac(st->n_bc[k*bi->n+i], st->n_pairs));
+		fprintf(fp, "}");
+	}
+	fprintf(fp, "\n  ],\n  \"memory\": {\"budget\": %lld, \"peak_in_flight\": %lld, \"max_chunk\": %lld, \"blocked\": %lld, \"blocked_sec\": %.3f, \"max_rss\": %lld},\n",
+			(long long)mem->budget, (long long)mem->peak, (long long)mem->max_chunk, (long long)mem->n_blocked, mem->t_blocked, (long long)r.ru_maxrss * 1024);
+	fprintf(fp, "  \"time\": {\n    \"wall\": %.3f,\n    \"cpu\": %.3f", lt_realtime() - t_start,
+			r.ru_utime.tv_sec + r.ru_stime.tv_sec + 1e-6 * (r.ru_utime.tv_usec + r.ru_stime.tv_usec));
+	for (i = 0; i < LT_N_STEPS; ++i) {
+		fprintf(fp, ",\n    \"%s\": {\"wall\": %.3f, \"cpu\": %.3f, \"queue_wait\": %.3f", lt_step_str[i], st->t_real[i], st->t_cpu[i], wait[i]);
+		if (i == LT_STEP_PROC)
+			for (k = 0; k < LT_N_SUB; ++k)
+				fprintf(fp, ", \"%s\": %.3f", lt_sub_str[k], st->t_sub[k]);
+		fprintf(fp, "}");
+	}
+	fprintf(fp, "\n  }\n}\n");
+	ret = fclose(fp);
+	if (ret == 0) ret = rename(tmp, fn);
+	return ret;
+}
+
+/*********************************
+ * Core trimming/merging routine *
+ *********************************/
+
+enum lt_out_e { LT_OUT_STDOUT = 0, LT_OUT_BGZF, LT_OUT_UNMERGED, LT_OUT_REJECT, LT_OUT_QC, LT_OUT_N }; // outputs recorded in checkpoints
+
+typedef struct lt_cons_s lt_cons_t;
+
+typedef struct {
+	lt_opt_t opt;
+	lt_bcidx_t *bi;
+	lt_bcres_t *br; // barcode rescue with -r, or NULL
+	lt_cells_t *cells; // cell ids of barcode pairs with -R, or NULL
+	bseq_file_t *fp, *fp2;
+	FILE *fpu; // unmerged output, or NULL
+	FILE *fpr; // pairs dropped by --require-bc, with --reject, or NULL
+	BGZF *fpo; // BGZF-compressed main output with -o, or NULL for stdout
+	FILE *fpq; // binary QC columns with -Q, or NULL
+	int qc_err; // set on failed writes to fpq
+	const char *fn_stats; // --stats output, or NULL
+	const char *fn_ckpt; // --checkpoint output, or NULL
+	int64_t n_out[LT_OUT_N]; // bytes written to each output but LT_OUT_BGZF
+	lt_stats_t *st;
+	int64_t n_chunks, n_read; // chunks written and pairs read so far
+	double t_start, wait[LT_N_STEPS]; // wait[] is updated by kt_pipeline_timed()
+	lt_mem_t mem;
+	int gen; // LT_GEN_* matchers in use
+	lt_cons_t *cons; // overlap consensus table
+} lt_global_t;
+
+void lt_global_init(lt_global_t *g)
+{
+	memset(g, 0, sizeof(lt_global_t));
+	lt_opt_init(&g->opt);
+}
+
+// trim a read by l basepairs from the 5' end
+static inline void trim_bseq_5(bseq1_t *s, int l)
+{
+	s->seq += l, s->qual += l;
+	s->l_seq -= l;
+}
+
+static inline int merge_base(int max_qual, int qmask, char fc, char fq, char rc, char rq)
+{
+	int y;
+	if (fc == rc) {
+		int q = fq > rq? (fq - 33) + (rq - 33) / 2 : (rq - 33) + (fq - 33) / 2;
+		y = toupper(fc) | (33 + (q < max_qual? q : max_qual)) << 8;
+	} else {
+		if (fq - 33 >= qmask && rq - 33 >= qmask) y = 'N' | 33 << 8;
+		else if (fq > rq) y = toupper(fc) | (33 + (fq - rq)) << 8;
+		else y = toupper(rc) | (33 + (rq - fq)) << 8;
+	}
+	return y;
+}
+
+/* Consensus over the overlap of a merged pair. Where the two bases agree, the quality comes from a (fq,rq)
+ * table built from max_qual by lt_cons_init(); disagreements go through merge_base(). The SSE2 kernel does
+ * both cases arithmetically, 16 bases at a time, and hands blocks with a quality outside [33,127] to the
+ * scalar code, so the output does not depend on the kernel. */
+
+struct lt_cons_s {
+	int max_qual, qmask;
+	uint8_t agree[256][256]; // indexed by (uint8_t)fq and (uint8_t)rq
+};
+
+static lt_cons_t *lt_cons_init(const lt_opt_t *opt)
+{
+	lt_cons_t *t;
+	int i, j;
+	t = (lt_cons_t*)malloc(sizeof(lt_cons_t));
+	t->max_qual = opt->max_qual, t->qmask = opt->qmask;
+	for (i = 0; i < 256; ++i)
+		for (j = 0; j < 256; ++j)
+			t->agree[i][j] = merge_base(t->max_qual, t->qmask, 'A', (char)i, 'A', (char)j) >> 8;
+	return t;
+}
+
+static inline void lt_cons1(const lt_cons_t *t, char fc, char fq, char rc, char rq, char *xc, char *xq)
+{
+	if (fc == rc) *xc = toupper(fc), *xq = t->agree[(uint8_t)fq][(uint8_t)rq];
+	else {
+		int y = merge_base(t->max_qual, t->qmask, fc, fq, rc, rq);
+		*xc = (uint8_t)y, *xq = y>>8;
+	}
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+static inline __m128i lt_toupper16(__m128i c)
+{
+	__m128i lower = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('z' + 1)));
+	return _mm_sub_epi8(c, _mm_and_si128(lower, _mm_set1_epi8(0x20)));
+}
+
+// the first l/16*16 bases of lt_cons(); max_qual must not be negative
+static int lt_cons_sse2(const lt_cons_t *t, int l, const char *fs, const char *fq, const char *rs, const char *rq, char *xs, char *xq)
+{
+	int i, k, thres = 33 + t->qmask;
+	__m128i c33 = _mm_set1_epi8(33), mask7f = _mm_set1_epi8(0x7f);
+	__m128i maxq = _mm_set1_epi8(t->max_qual > 255? (char)255 : (char)t->max_qual);
+	__m128i thr = _mm_set1_epi8(thres < 0? 0 : thres > 255? (char)255 : (char)thres);
+	for (i = 0; i + 16 <= l; i += 16) {
+		__m128i f = _mm_loadu_si128((const __m128i*)(fs + i)), r = _mm_loadu_si128((const __m128i*)(rs + i));
+		__m128i a = _mm_loadu_si128((const __m128i*)(fq + i)), b = _mm_loadu_si128((const __m128i*)(rq + i));
+		__m128i eq, hi, lo, qa, qd, nm, gt, base, qual;
+		if (_mm_movemask_epi8(_mm_or_si128(_mm_cmplt_epi8(a, c33), _mm_cmplt_epi8(b, c33)))) { // qualities out of range
+			for (k = i; k < i + 16; ++k)
+				lt_cons1(t, fs[k], fq[k], rs[k], rq[k], &xs[k], &xq[k]);
+			continue;
+		}
+		eq = _mm_cmpeq_epi8(f, r);
+		hi = _mm_max_epu8(a, b), lo = _mm_min_epu8(a, b);
+		qa = _mm_add_epi8(_mm_sub_epi8(hi, c33), _mm_and_si128(_mm_srli_epi16(_mm_sub_epi8(lo, c33), 1), mask7f)); // (hi-33) + (lo-33)/2
+		qa = _mm_add_epi8(_mm_min_epu8(qa, maxq), c33);
+		nm = thres <= 0? _mm_set1_epi8(-1) : thres > 255? _mm_setzero_si128() : _mm_cmpeq_epi8(_mm_max_epu8(lo, thr), lo); // both qualities >= qmask
+		qd = _mm_andnot_si128(nm, _mm_sub_epi8(hi, lo));
+		qd = _mm_add_epi8(qd, c33);
+		f = lt_toupper16(f), r = lt_toupper16(r);
+		gt = _mm_cmpgt_epi8(a, b);
+		base = _mm_or_si128(_mm_and_si128(gt, f), _mm_andnot_si128(gt, r));
+		base = _mm_or_si128(_mm_and_si128(nm, _mm_set1_epi8('N')), _mm_andnot_si128(nm, base));
+		base = _mm_or_si128(_mm_and_si128(eq, f), _mm_andnot_si128(eq, base));
+		qual = _mm_or_si128(_mm_and_si128(eq, qa), _mm_andnot_si128(eq, qd));
+		_mm_storeu_si128((__m128i*)(xs + i), base);
+		_mm_storeu_si128((__m128i*)(xq + i), qual);
+	}
+	return i;
+}
+#endif
+
+// write the consensus of fs/fq and rs/rq over _l_ bases to xs/xq
+static void lt_cons(const lt_cons_t *t, int l, const char *fs, const char *fq, const char *rs, const char *rq, char *xs, char *xq)
+{
+	int i = 0;
+#if defined(__x86_64__) && defined(__GNUC__)
+	if (lt_simd >= 1 && t->max_qual >= 0) i = lt_cons_sse2(t, l, fs, fq, rs, rq, xs, xq);
+#endif
+	for (; i < l; ++i)
+		lt_cons1(t, fs[i], fq[i], rs[i], rq[i], &xs[i], &xq[i]);
+}
+
+/* Bit-parallel lt_ue_for() for a query without qualities, used for the adapters. Bit p of a word tracks the
+ * extension of s2 from s1[p]. We walk s2 column by column: the offsets mismatching at a column add their
+ * penalties to bit-sliced counters and are dropped if they trigger the early-exit rule of lt_ue_for1().
+ * Offsets still alive when they reach the end of s1 or s2 are hits. */
+
+#define LT_BP_MAX_PLANES 16
+
+// add _v_ to the bit-sliced counters c[0], c[stride], ... at the positions set in _m_
+static inline void lt_bp_add(uint64_t *c, int stride, int n_planes, uint64_t m, int v)
+{
+	int b, k;
+	for (b = 0; v; ++b, v >>= 1) {
+		uint64_t carry = v&1? m : 0;
+		for (k = b; k < n_planes && carry; ++k) {
+			uint64_t t = c[k * stride] & carry;
+			c[k * stride] ^= carry;
+			carry = t;
+		}
+	}
+}
+
+// positions where the bit-sliced counter is greater than _t_
+static inline uint64_t lt_bp_gt(const uint64_t *c, int stride, int n_planes, int t)
+{
+	uint64_t gt = 0, eq = ~0ULL;
+	int b;
+	for (b = n_planes - 1; b >= 0; --b) {
+		uint64_t x = c[b * stride];
+		if (t>>b&1) eq &= x;
+		else gt |= eq & x, eq &= ~x;
+	}
+	return gt;
+}
+
+// set bit x of eq[c*stride] if s[x] is the c-th of "ACGT", and bit x of hq if q[x] >= LT_QUAL_THRES
+static void lt_bp_mask(int l, const char *s, const char *q, uint64_t *eq, int stride, uint64_t *hq)
+{
+	int x = 0;
+#if defined(__x86_64__) && defined(__GNUC__)
+	if (lt_simd) { // 16 bases at a time; x is a multiple of 16, so a block never straddles two words
+		const __m128i a = _mm_set1_epi8('A'), c = _mm_set1_epi8('C'), g = _mm_set1_epi8('G'), t = _mm_set1_epi8('T');
+		const __m128i thres = _mm_set1_epi8(LT_QUAL_THRES - 1);
+		for (; x + 16 <= l; x += 16) {
+			__m128i v = _mm_loadu_si128((const __m128i*)(s + x)), u = _mm_loadu_si128((const __m128i*)(q + x));
+			int w = x>>6, sh = x&63;
+			eq[w]            |= (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, a)) << sh;
+			eq[w + stride]   |= (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, c)) << sh;
+			eq[w + stride*2] |= (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, g)) << sh;
+			eq[w + stride*3] |= (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, t)) << sh;
+			hq[w]            |= (uint64_t)_mm_movemask_epi8(_mm_cmpgt_epi8(u, thres)) << sh;
+		}
+	}
+#endif
+	for (; x < l; ++x) {
+		int c = lt_nt4_table[(uint8_t)s[x]];
+		if (c < 4) eq[c * stride + (x>>6)] |= 1ULL << (x&63);
+		if (q[x] >= LT_QUAL_THRES) hq[x>>6] |= 1ULL << (x&63);
+	}
+}
+
+typedef struct {
+	int n_words;
+	uint64_t *eq, *hq, *alive, *cnt;
+} lt_bp_t;
+
+#define lt_bp_size(l1, n_planes) (((((l1) + 63) >> 6) * ((n_planes) + 6) + 5) * sizeof(uint64_t)) // bytes for lt_bp_init()
+
+// set up the masks of s1 and the offsets with room for min_len bases; _mem_ has lt_bp_size() bytes
+static inline void lt_bp_init(lt_bp_t *b, int l1, const char *s1, const char *q1, int min_len, int n_planes, void *mem)
+{
+	int x;
+	b->n_words = (l1 + 63) >> 6;
+	memset(mem, 0, lt_bp_size(l1, n_planes));
+	// eq[c] and hq are padded by one word for the shifts in lt_bp_col()
+	b->eq = (uint64_t*)mem;
+	b->hq = b->eq + (b->n_words + 1) * 4, b->alive = b->hq + b->n_words + 1, b->cnt = b->alive + b->n_words;
+	lt_bp_mask(l1, s1, q1, b->eq, b->n_words + 1, b->hq);
+	for (x = 0; x <= l1 - min_len; x += 64) // extensions from s1[x] with at least min_len bases
+		b->alive[x>>6] = l1 - min_len - x >= 63? ~0ULL : (1ULL << (l1 - min_len - x + 1)) - 1;
+}
+
+// column _j_ of s2, with base _c_ and max penalty _t_; return 0 if no offset is alive. The generated matchers
+// call this with constant arguments, which unrolls the counter updates.
+static inline __attribute__((always_inline)) int lt_bp_col(lt_bp_t *b, int l1, int n_planes, int j, int c, int t)
+{
+	const uint64_t *e = b->eq + c * (b->n_words + 1) + (j>>6), *h = b->hq + (j>>6);
+	int w, r = j&63, lim = l1 - j, n_words = b->n_words;
+	uint64_t any = 0;
+	for (w = 0; w << 6 < lim; ++w) { // offsets p < lim have not reached the end of s1
+		uint64_t m = b->alive[w], ew, hw, mm;
+		if (lim - (w << 6) < 64) m &= (1ULL << (lim - (w << 6))) - 1;
+		if (m == 0) continue;
+		any |= m;
+		ew = r? e[w] >> r | e[w+1] << (64 - r) : e[w]; // s1[p+j]==s2[j] at bit p
+		if ((mm = m & ~ew) == 0) continue;
+		hw = r? h[w] >> r | h[w+1] << (64 - r) : h[w];
+		lt_bp_add(b->cnt + w, n_words, n_planes, mm & hw, LT_HIGH_PEN);
+		lt_bp_add(b->cnt + w, n_words, n_planes, mm & ~hw, LT_LOW_PEN);
+		b->alive[w] &= ~(mm & lt_bp_gt(b->cnt + w, n_words, n_planes, t));
+	}
+	return any != 0;
+}
+
+// report hits in the order of lt_ue_for(), from the 3'-end
+static int lt_bp_report(const lt_bp_t *b, int l1, int l2, int max_pos, uint64_t *pos)
+{
+	int w, n = 0;
+	for (w = b->n_words - 1; w >= 0; --w) {
+		uint64_t m = b->alive[w];
+		while (m) {
+			int p = (w << 6) + 63 - __builtin_clzll(m), i = l1 - p;
+			pos[n++] = (uint64_t)p << 32 | (i < l2? i : l2);
+			if (n == max_pos) return n;
+			m &= ~(1ULL << (p&63));
+		}
+	}
+	return n;
+}
+
+int lt_ue_for_bp(int l1, const char *s1, const char *q1, int l2, const char *s2, int max_pen, int min_len, int max_pos, uint64_t *pos)
+{
+	int j, n_planes, t_max;
+	lt_bp_t b;
+	if (l1 < min_len || l2 < min_len) return 0;
+	for (j = 0; j < l2; ++j)
+		if (lt_nt4_table[(uint8_t)s2[j]] > 3) break;
+	t_max = (l2 - 1) * max_pen / min_len > max_pen? (l2 - 1) * max_pen / min_len : max_pen;
+	for (n_planes = 1; 1<<n_planes <= t_max + LT_HIGH_PEN; ++n_planes);
+	if (j < l2 || n_planes > LT_BP_MAX_PLANES)
+		return lt_ue_for(l1, s1, q1, l2, s2, 0, max_pen, min_len, max_pos, pos);
+	lt_bp_init(&b, l1, s1, q1, min_len, n_planes, alloca(lt_bp_size(l1, n_planes)));
+	for (j = 0; j < l2; ++j)
+		if (!lt_bp_col(&b, l1, n_planes, j, lt_nt4_table[(uint8_t)s2[j]], j * max_pen / min_len > max_pen? j * max_pen / min_len : max_pen))
+			break;
+	return lt_bp_report(&b, l1, l2, max_pos, pos);
+}
+
+/* gen-matchers specializes the barcode scan and the adapter search for the chemistry in chemistry.h at build
+ * time: the automaton becomes constant tables and lt_ue_for_bp() is unrolled over the adapter bases. They are
+ * only used when the loaded barcodes and the adapter options are those they were generated for. */
+
+#include "matchers.h"
+
+#define LT_GEN_BC   0x1 // barcodes scanned by lt_gen_bc_scan()
+#define LT_GEN_ADAP 0x2 // adapters searched by lt_gen_adap1_for() and lt_gen_adap2_for()
+
+static int lt_gen_bc_scan(int l, const char *s, uint64_t *hits)
+{
+	return lt_bcidx_scan1(lt_gen_bc_next, lt_gen_bc_out, lt_gen_bc_olink, lt_gen_bc_len, l, s, hits);
+}
+
+// return the LT_GEN_* matchers that give the same results as the generic ones for _bi_ and _opt_
+static int lt_gen_check(const lt_bcidx_t *bi, const lt_opt_t *opt)
+{
+	int i, flag = 0;
+	if (bi->n == LT_GEN_BC_N && bi->n_nodes == LT_GEN_BC_NODES && bi->max_out == LT_GEN_BC_MAX_OUT) {
+		for (i = 0; i < bi->n; ++i)
+			if (strcmp(bi->seq[i], lt_gen_bc_seq[i]) != 0) break;
+		if (i == bi->n && memcmp(bi->next, lt_gen_bc_next, sizeof(lt_gen_bc_next)) == 0 && memcmp(bi->out, lt_gen_bc_out, sizeof(lt_gen_bc_out)) == 0
+			&& memcmp(bi->olink, lt_gen_bc_olink, sizeof(lt_gen_bc_olink)) == 0)
+			flag |= LT_GEN_BC;
+	}
+	if (opt->max_adap_pen == LT_GEN_ADAP_PEN && opt->min_adap_len == LT_GEN_ADAP_MIN_LEN && strcmp(lt_adapter1, LT_GEN_ADAP1) == 0 && strcmp(lt_adapter2, LT_GEN_ADAP2) == 0)
+		flag |= LT_GEN_ADAP;
+	return flag;
+}
+
+// trim or mask the adapter given _n_hits_ hits from lt_ue_for()/lt_ue_rev(); return 1 if anything is done
+static inline int trim_adap_hits(bseq1_t *s, int is_5, int min_len, int allow_contained, int n_hits, const uint64_t *hits)
+{
+	if (n_hits > 0 && (allow_contained || (hits[0]>>32) + (uint32_t)hits[0] == s->l_seq || (hits[n_hits-1]>>32) + (uint32_t)hits[n_hits-1] == s->l_seq)) {
+		int len = s->l_seq - (hits[n_hits-1]>>32); // trim the longest hit
+		if (is_5) {
+			if (len > min_len) trim_bseq_5(s, len); // trim
+			else memset(s->qual, 33+1, len); // reduce baseQ
+		} else {
+			if (len > min_len) s->l_seq -= len, s->seq[s->l_seq] = s->qual[s->l_seq] = 0; // trim
+			else memset(s->qual + (s->l_seq - len), 33+1, len); // reduce baseQ
+		}
+		return 1;
+	}
+	return 0;
+}
+
+// return 1 if an adapter has been trimmed or masked
+static inline int trim_adap(bseq1_t *s, const char *adap, int is_5, int min_len, int max_pen, int allow_contained)
+{
+	int n_hits, l_adap;
+	uint64_t hits[4];
+	l_adap = strlen(adap);
+	if (is_5) n_hits = lt_ue_rev(s->l_seq, s->seq, s->qual, l_adap, adap, 0, max_pen, min_len, 4, hits);
+	else n_hits = lt_ue_for_bp(s->l_seq, s->seq, s->qual, l_adap, adap, max_pen, min_len, 4, hits);
+	return trim_adap_hits(s, is_5, min_len, allow_contained, n_hits, hits);
+}
+
+//By Bowen Jin
+// _hits_ holds the n_hits barcode occurrences in _s0_, the read before trimming; see lt_bcidx_scan(). If
+// _n_trim_ is not NULL, n_trim[i] is incremented when barcode i is trimmed; _trim_id_ gets i at the 5'-end.
+static inline void trim_olig_bc(bseq1_t *s, const lt_bcidx_t *bi, const char *s0, int n_hits, const uint64_t *hits, int is_5, int min_len, int *trim_pos, int *trim_id, char *trim_seq, int64_t *n_trim)
+{
+	int i, j, d;
+	
+	for (i = 0; i < bi->n; i++){ 
+		int l_bc = bi->len[i], lo = s->seq - s0, hi = lo + s->l_seq, n_hits_bc = 0;
+		const char *bc = bi->seq[i];
+		if (l_bc < min_len) continue;
+		for (j = 0; j < n_hits; ++j) // full barcodes inside the current read
+			if ((uint32_t)hits[j] == i && hits[j]>>32 >= lo && (hits[j]>>32) + l_bc <= hi) ++n_hits_bc;
+		for (d = min_len; d < l_bc && d <= hi - lo; ++d) // a partial barcode at the 3'-end (is_5) or 5'-end
+			if (is_5? memcmp(s0 + hi - d, bc, d) == 0 : memcmp(s0 + lo, bc + l_bc - d, d) == 0) ++n_hits_bc;
+		if(n_hits_bc == 1) {
+			int len = l_bc + 19;
+
+			if (s->l_seq <= len) {return;}
+			if (n_trim) ++n_trim[i];
+
+			if (is_5) {
+				if (len > min_len) { // trim
+					if (trim_seq) {
+						strncpy(trim_seq, s->seq, len);
+						trim_seq[len] = 0;
+						*trim_pos = len;
+					}
+					if (trim_id) *trim_id = i;
+					trim_bseq_5(s, len); 
+				} else {
+					memset(s->qual, 33+1, len); // reduce baseQ
+				}
+			} else {
+				if (len > min_len) {  // trim
+					s->l_seq -= len, s->seq[s->l_seq] = s->qual[s->l_seq] = 0;
+				} else {
+					memset(s->qual + (s->l_seq - len), 33+1, len); // reduce baseQ
+				}
+			}
+		}
+	}
+}
+//
+
+// merge the two ends of a trimmed pair; on success, s[0] holds the merged fragment and s[1] is emptied
+static void lt_merge(const lt_global_t *g, bseq1_t s[2], lt_arena_t *ar)
+{
+	int mlen, n_fh, n_rh, n_ch;
+	uint64_t fh[2], rh[2], ch[2];
+	char *rseq, *rqual, *xseq, *xqual;
+	lt_pk_t p0, p1;
+	mlen = s[0].l_seq > s[1].l_seq? s[0].l_seq : s[1].l_seq;
+	rseq = (char*)alloca(mlen + 1);
+	rqual = (char*)alloca(mlen + 1);
+	// reverse the other read
+	lt_seq_rev(s[1].l_seq, s[1].qual, rqual);
+	// find overlaps
+	if (g->opt.merge_exact) {
+		lt_seq_revcomp(s[1].l_seq, s[1].seq, rseq);
+		n_fh = lt_ue_for(s[0].l_seq, s[0].seq, s[0].qual, s[1].l_seq, rseq, rqual, g->opt.max_ovlp_pen, g->opt.min_ovlp_len, 2, fh);
+		if (n_fh > 0 && fh[0]>>32 == 0 && s[0].l_seq == s[1].l_seq && (int32_t)fh[0] == s[0].l_seq) n_rh = 0; // complete overlap; don't test ue_rev()
+		else n_rh = lt_ue_rev(s[0].l_seq, &s[0].seq[0], &s[0].qual[0], s[1].l_seq, rseq, rqual, g->opt.max_ovlp_pen, g->opt.min_ovlp_len, 2, rh);
+		n_ch = lt_ue_contained(s[0].l_seq, &s[0].seq[0], &s[0].qual[0], s[1].l_seq, rseq, rqual, g->opt.max_ovlp_pen, 2, ch);
+	} else { // on packed reads; rseq is decoded only if the pair is merged
+		lt_pk_t f1;
+		int n0 = lt_pk_size(s[0].l_seq), n1 = lt_pk_size(s[1].l_seq);
+		uint64_t *w = (uint64_t*)alloca((n0 + n1 * 2) * 2 * sizeof(uint64_t));
+		lt_pk_init(&p0, s[0].l_seq, s[0].seq, w, w + n0);
+		lt_pk_init(&f1, s[1].l_seq, s[1].seq, w + n0 * 2, w + n0 * 2 + n1);
+		lt_pk_revcomp(&f1, &p1, w + (n0 + n1) * 2, w + (n0 + n1) * 2 + n1);
+		n_fh = lt_ue_for_pk(&p0, s[0].qual, &p1, rqual, g->opt.max_ovlp_pen, g->opt.min_ovlp_len, 2, fh);
+		if (n_fh > 0 && fh[0]>>32 == 0 && s[0].l_seq == s[1].l_seq && (int32_t)fh[0] == s[0].l_seq) n_rh = 0;
+		else n_rh = lt_ue_rev_pk(&p0, s[0].qual, &p1, rqual, g->opt.max_ovlp_pen, g->opt.min_ovlp_len, 2, rh);
+		n_ch = lt_ue_contained_pk(&p0, s[0].qual, &p1, rqual, g->opt.max_ovlp_pen, 2, ch);
+	}
+	if (n_fh + n_rh + n_ch > 1) {
+		s[0].type = s[1].type = LT_MERGE_AMBIGUOUS;
+	} else if (n_fh + n_rh + n_ch == 0) {
+		s[0].type = s[1].type = LT_NO_MERGE;
+	} else {
+		int x = 0;
+		xseq = (char*)lt_arena_alloc(ar, s[0].l_seq + s[1].l_seq + 1); // the merged fragment is built in place
+		xqual = (char*)lt_arena_alloc(ar, s[0].l_seq + s[1].l_seq + 1);
+		if (!g->opt.merge_exact) lt_pk_decode(&p1, rseq);
+		if (n_fh == 1) {
+			int l = (uint32_t)fh[0], st = fh[0]>>32;
+			if (l < s[1].l_seq) { // partial overlap
+				s[0].type = s[1].type = LT_MERGE_PARTIAL;
+				s[0].merge_pos_l = s[1].merge_pos_l = st;
+				s[0].merge_pos_r = s[1].merge_pos_r = st + l - 1;
+				memcpy(xseq, s[0].seq, st), memcpy(xqual, s[0].qual, st); // read1 non-overlap
+				lt_cons(g->cons, l, s[0].seq + st, s[0].qual + st, rseq, rqual, xseq + st, xqual + st); // overlap (l=length of overlap)
+				x = st + l;
+				memcpy(xseq + x, rseq + l, s[1].l_seq - l), memcpy(xqual + x, rqual + l, s[1].l_seq - l); // read2 non-overlap
+				x += s[1].l_seq - l;
+			} else { // s[1] is contained in s[0]
+				s[0].type = s[1].type = LT_MERGE_COMPLETE_FH;
+				s[0].merge_pos_l = s[1].merge_pos_l = st;
+				s[0].merge_pos_r = s[1].merge_pos_r = st + l - 1;
+				// discard the non-overlapping fragment which is likely to be transposon BC/adapter from the other read
+				lt_cons(g->cons, l, s[0].seq + st, s[0].qual + st, rseq, rqual, xseq, xqual);
+				x = l;
+			}
+		} else if (n_rh == 1) { // s[1] is contained in s[0], i.e. s[0] non-overlap left + l/s[1], discard s[0] non-overlap right
+			int l = (uint32_t)rh[0], st = rh[0]>>32, j = s[0].l_seq - st - l;
+			s[0].type = s[1].type = LT_MERGE_COMPLETE_RH;
+			s[0].merge_pos_l = s[1].merge_pos_l = j;
+			s[0].merge_pos_r = s[1].merge_pos_r = s[0].l_seq - st - 1;
+			memcpy(xseq, s[0].seq, j), memcpy(xqual, s[0].qual, j);
+			lt_cons(g->cons, l, s[0].seq + j, s[0].qual + j, rseq + s[1].l_seq - l, rqual + s[1].l_seq - l, xseq + j, xqual + j);
+			x = j + l;
+		} else { // s[0] is contained in s[1]
+			int st = ch[0]>>32;
+			s[0].type = s[1].type = LT_MERGE_COMPLETE_CH;
+			s[0].merge_pos_l = s[1].merge_pos_l = 0;
+			s[0].merge_pos_r = s[1].merge_pos_r = s[0].l_seq - 1;
+			lt_cons(g->cons, s[0].l_seq, s[0].seq, s[0].qual, rseq + st, rqual + st, xseq, xqual);
+			x = s[0].l_seq;
+		}
+		xseq[x] = xqual[x] = 0;
+		if (x < g->opt.min_seq_len) s[0].type = s[1].type = LT_SHORT_SEQ;
+		s[0].seq = xseq, s[0].qual = xqual;
+		s[0].l_seq = x;
+		s[1].l_seq = 0;
+	}
+}
+
+#define LT_OLIGO_LEN 19
+
+// whether the transposons trimmed at _olig_pos_ leave a barcode at both ends, for bc_cat in lt_finish()
+static inline int lt_has_bc(const lt_opt_t *opt, const int olig_pos[2])
+{
+	return olig_pos[0] > LT_OLIGO_LEN + opt->bc_cut && olig_pos[1] > LT_OLIGO_LEN + opt->bc_cut;
+}
+
+// classify short reads and record the barcodes found in the trimming
+static void lt_finish(const lt_global_t *g, bseq1_t s[2], const int olig_pos0[2], const int bc_id0[2], char *const bc0[2], lt_arena_t *ar)
+{
+	int i, k, olig_pos[2], bc_id[2], oligo_len=LT_OLIGO_LEN;
+	char *bc[2];
+	olig_pos[0] = olig_pos0[0], olig_pos[1] = olig_pos0[1];
+	bc_id[0] = bc_id0[0], bc_id[1] = bc_id0[1];
+	bc[0] = bc0[0], bc[1] = bc0[1];
+
+	// check whether read length is too short
+    if (s[0].l_seq < g->opt.min_seq_len) {
+        if (s[0].type == LT_MERGE_PARTIAL || s[0].type == LT_MERGE_COMPLETE || s[0].type == LT_MERGE_COMPLETE_FH || s[0].type == LT_MERGE_COMPLETE_RH || s[0].type == LT_MERGE_COMPLETE_CH ) { // single-end
+            s[0].type = s[1].type = LT_SHORT_SEQ;
+        } else if (s[1].l_seq >= g->opt.min_seq_len) { // read 1 is short, but read 2 is not => swap
+			char *tmp;
+			tmp = s[0].seq, s[0].seq = s[1].seq, s[1].seq = tmp;
+			tmp = s[0].qual, s[0].qual = s[1].qual, s[1].qual = tmp;
+			tmp = bc[0], bc[0] = bc[1], bc[1] = tmp;
+			i = olig_pos[0], olig_pos[0] = olig_pos[1], olig_pos[1] = i;
+			i = bc_id[0], bc_id[0] = bc_id[1], bc_id[1] = i;
+			i = s[0].l_seq, s[0].l_seq = s[1].l_seq, s[1].l_seq = i;
+            s[0].type = s[1].type = LT_SHORT_PE_SWAP;
+        } else {
+            s[0].type = s[1].type = LT_SHORT_SEQ;
+        }
+    } else if (s[0].type != LT_MERGE_PARTIAL && s[0].type != LT_MERGE_COMPLETE && s[0].type != LT_MERGE_COMPLETE_FH && s[0].type != LT_MERGE_COMPLETE_RH && s[0].type != LT_MERGE_COMPLETE_CH && s[1].l_seq < g->opt.min_seq_len) { // read 2 is short, but read 1 is not
+        s[0].type = s[1].type = LT_SHORT_PE;
+    }
+    
+    // record the barcodes; both ends share the same strings in the arena
+	s[0].bc_f = s[1].bc_f = lt_arena_strndup(ar, bc[0], strlen(bc[0]));
+	s[0].bc_r = s[1].bc_r = lt_arena_strndup(ar, bc[1], strlen(bc[1]));
+	s[0].bc_cat = s[1].bc_cat = 0;
+	if (lt_has_bc(&g->opt, olig_pos)) {
+		int l[2];
+		l[0] = olig_pos[0] - (oligo_len + g->opt.bc_cut);
+		l[1] = olig_pos[1] - (oligo_len + g->opt.bc_cut);
+		s[0].bc_cat = s[1].bc_cat = (char*)lt_arena_alloc(ar, l[0] + l[1] + 1);
+		memset(s[0].bc_cat, 0, l[0] + l[1] + 1);
+		strncpy(s[0].bc_cat,        &s[0].bc_f[g->opt.bc_cut], l[0]);
+		strncpy(&s[0].bc_cat[l[0]], &s[0].bc_r[g->opt.bc_cut], l[1]);
+		if (g->cells) s[0].cell = s[1].cell = lt_cells_get(g->cells, s[0].bc_cat);
+	}
+	for (k = 0; k < 2; ++k) {
+		s[k].olig_pos_f = olig_pos[0];
+		s[k].olig_pos_r = olig_pos[1];
+		s[k].bc_id_f = bc_id[0], s[k].bc_id_r = bc_id[1];
+	}
+}
+
+// trim N and the Illumina adapters from both ends of a pair
+static void lt_trim_ends(const lt_global_t *g, bseq1_t s[2], lt_stats_t *st)
+{
+	int i, k;
+	double t = 0.0, t1;
+	if (st) t = lt_realtime();
+
+	// trim heading and trailing N
+	for (k = 0; k < 2; ++k) {
+		bseq1_t *sk = &s[k];
+		for (i = sk->l_seq - 1; i >= 0; --i) // trim trailing "N"
+			if (sk->seq[i] != 'N') break;
+		sk->l_seq = i + 1;
+		sk->seq[sk->l_seq] = sk->qual[sk->l_seq] = 0;
+		for (i = 0; i < sk->l_seq; ++i) // trim heading "N"
+			if (sk->seq[i] != 'N') break;
+		if (i) trim_bseq_5(sk, i);
+	}
+	if (st) t1 = lt_realtime(), st->t_sub[LT_SUB_NTRIM] += t1 - t, t = t1;
+	
+	// trim Illumina PE adapters
+	if (g->gen & LT_GEN_ADAP) {
+		uint64_t hits[4];
+		k = trim_adap_hits(&s[0], 0, g->opt.min_adap_len, 1, lt_gen_adap1_for(s[0].l_seq, s[0].seq, s[0].qual, 4, hits), hits);
+		i = trim_adap_hits(&s[1], 0, g->opt.min_adap_len, 1, lt_gen_adap2_for(s[1].l_seq, s[1].seq, s[1].qual, 4, hits), hits);
+	} else {
+		k = trim_adap(&s[0], lt_adapter1, 0, g->opt.min_adap_len, g->opt.max_adap_pen, 1);
+		i = trim_adap(&s[1], lt_adapter2, 0, g->opt.min_adap_len, g->opt.max_adap_pen, 1);
+	}
+	if (st) {
+		st->n_adap[0] += k, st->n_adap[1] += i;
+		st->t_sub[LT_SUB_ADAP] += lt_realtime() - t;
+	}
+}
+
+// trim the transposons off a pair processed by lt_trim_ends(), store the barcodes and merge the two ends.
+// Return 0 if the pair is dropped by --require-bc, in which case it is neither merged nor copied to _u_.
+static int lt_process_trimmed(const lt_global_t *g, bseq1_t s[2], bseq1_t u[2], lt_arena_t *ar, lt_stats_t *st)
+{
+	int k, mlen, olig_pos[2], bc_id[2], n_bc_hits;
+	char *bc[2], *s0;
+	uint64_t *bc_hits;
+	double t = 0.0, t1;
+	mlen = s[0].l_seq > s[1].l_seq? s[0].l_seq : s[1].l_seq;
+	if (st) t = lt_realtime();
+
+	// trim transposon sequences and store barcodes
+
+	for (k = 0; k < 2; ++k) {
+		olig_pos[k] = 0, bc_id[k] = -1;
+		bc[k] = (char*)alloca(mlen + 1);
+		bc[k][0] = 0;
+		//By Bowen Jin
+		bc_hits = (uint64_t*)alloca((s[k].l_seq + 1) * g->bi->max_out * sizeof(uint64_t));
+		n_bc_hits = g->gen & LT_GEN_BC? lt_gen_bc_scan(s[k].l_seq, s[k].seq, bc_hits) : lt_bcidx_scan(g->bi, s[k].l_seq, s[k].seq, bc_hits);
+		s0 = s[k].seq;
+		trim_olig_bc(&s[k], g->bi, s0, n_bc_hits, bc_hits, 1, 11, &olig_pos[k], &bc_id[k], bc[k], st? &st->n_bc[k * g->bi->n] : 0);
+		if (g->br && olig_pos[k] == 0) { // no exact barcode; try the inexact ones
+			int id = lt_bcres_get(g->br, s[k].l_seq, s[k].seq), len;
+			if (id >= 0 && s[k].l_seq > (len = g->bi->len[id] + 19)) { // record the canonical barcode+transposon
+				strcat(strcpy(bc[k], g->bi->seq[id]), lt_oligo_for);
+				olig_pos[k] = len, bc_id[k] = id;
+				trim_bseq_5(&s[k], len);
+				if (st) ++st->n_rescue[k], ++st->n_bc[k * g->bi->n + id];
+			} else if (id == -2 && st) ++st->n_rescue_ambi[k];
+		}
+		trim_olig_bc(&s[k], g->bi, s0, n_bc_hits, bc_hits, 0, 11, 0, 0, 0, 0); 
+		//
+	}
+	if (st) t1 = lt_realtime(), st->t_sub[LT_SUB_BC] += t1 - t, t = t1;
+
+	if (g->opt.require_bc && !lt_has_bc(&g->opt, olig_pos)) { // no barcode pair to tag the pair with
+		s[0].type = s[1].type = LT_NO_MERGE;
+		lt_finish(g, s, olig_pos, bc_id, bc, ar);
+		if (st) ++st->n_nobc, st->t_sub[LT_SUB_MERGE] += lt_realtime() - t;
+		return 0;
+	}
+	if (u) { // the unmerged copy; merging does not touch the sequences s[] point to
+		u[0] = s[0], u[1] = s[1];
+		u[0].type = u[1].type = LT_NO_MERGE;
+		lt_finish(g, u, olig_pos, bc_id, bc, ar);
+	}
+	if (g->opt.no_merge) s[0].type = s[1].type = LT_NO_MERGE;
+	else lt_merge(g, s, ar);
+	lt_finish(g, s, olig_pos, bc_id, bc, ar);
+	if (st) {
+		++st->n_type[s[0].type];
+		if (u) ++st->n_utype[u[0].type];
+		if (s[0].cell >= 0) ++st->n_cell;
+		if (s[0].bc_cat == 0) ++st->n_nobc;
+		st->t_sub[LT_SUB_MERGE] += lt_realtime() - t;
+	}
+	return 1;
+}
+
+// trim a pair and merge it; if _u_ is not NULL, it gets the unmerged pair, as with -M, from the same trimming.
+// If _st_ is not NULL, the counts and the time spent in each sub-stage are added to it. Return 0 if the pair
+// is dropped by --require-bc.
+int lt_process(const lt_global_t *g, bseq1_t s[2], bseq1_t u[2], lt_arena_t *ar, lt_stats_t *st)
+{
+	if (st) ++st->n_pairs, st->n_bases_in += s[0].l_seq + s[1].l_seq;
+	lt_trim_ends(g, s, st);
+	return lt_process_trimmed(g, s, u, ar, st);
+}
+
+/****************
+ * Batch engine *
+ ****************/
+
+/* With -E, worker_for() passes LT_BATCH pairs at a time to lt_batch_trim_ends(). The reads on each side are
+ * transposed into a structure-of-arrays: column x holds base x of every lane, so one vector compare tests a
+ * position in 32 (AVX2) or 16 (SSE2) reads. N-trimming and the 3' adapter search run on all lanes in
+ * lockstep, and the trims are then applied to the reads as lt_trim_ends() would. The barcode automaton follows
+ * data-dependent transitions and stays per read. */
+
+#define LT_BATCH 32 // lanes; bit i of a lane mask is lane i
+
+typedef struct {
+	int n, max_len;
+	int beg[LT_BATCH], end[LT_BATCH]; // after N-trimming, lane i is [beg[i],end[i]) of its read
+	uint8_t *seq, *qual; // seq[x*LT_BATCH+i] is base x of lane i
+	uint32_t *in, *began; // in[x]: lanes with end[i]>x; began[x]: lanes with beg[i]<=x
+} lt_soa_t;
+
+// turn in[x], the lanes ending at x, into the lanes ending after x
+static void lt_soa_suffix_or(uint32_t *in, int l)
+{
+	uint32_t acc = 0, e;
+	int x;
+	for (x = l; x >= 0; --x)
+		e = in[x], in[x] = acc, acc |= e;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+// write row r of the 16x16 block src[0..15][0..15] to dst[0..15][r], where dst[c] is at dst+c*stride
+static inline void lt_soa_tr16(const uint8_t *const src[16], uint8_t *dst, int stride)
+{
+	__m128i a[16], t[16];
+	int i, h, c;
+	for (i = 0; i < 16; ++i) a[i] = _mm_loadu_si128((const __m128i*)src[i]);
+	for (i = 0; i < 8; ++i) // pairs of rows
+		t[i<<1] = _mm_unpacklo_epi8(a[i<<1], a[i<<1|1]), t[i<<1|1] = _mm_unpackhi_epi8(a[i<<1], a[i<<1|1]);
+	for (i = 0; i < 4; ++i) { // groups of 4 rows; a[4i+c] has columns 4c..4c+3
+		a[i<<2]   = _mm_unpacklo_epi16(t[i<<2],   t[i<<2|2]), a[i<<2|1] = _mm_unpackhi_epi16(t[i<<2],   t[i<<2|2]);
+		a[i<<2|2] = _mm_unpacklo_epi16(t[i<<2|1], t[i<<2|3]), a[i<<2|3] = _mm_unpackhi_epi16(t[i<<2|1], t[i<<2|3]);
+	}
+	for (h = 0; h < 2; ++h) // groups of 8 rows; t[8h+j] has columns 2j and 2j+1
+		for (c = 0; c < 4; ++c)
+			t[h<<3|c<<1] = _mm_unpacklo_epi32(a[h<<3|c], a[h<<3|4|c]), t[h<<3|c<<1|1] = _mm_unpackhi_epi32(a[h<<3|c], a[h<<3|4|c]);
+	for (c = 0; c < 8; ++c) {
+		_mm_storeu_si128((__m128i*)(dst + (c<<1) * stride), _mm_unpacklo_epi64(t[c], t[8|c]));
+		_mm_storeu_si128((__m128i*)(dst + (c<<1|1) * stride), _mm_unpackhi_epi64(t[c], t[8|c]));
+	}
+}
+#endif
+
+// transpose _n_ reads s[0], s[stride], ... into _a_; the lanes are not N-trimmed yet
+static void lt_soa_init(lt_soa_t *a, int n, const bseq1_t *s, int stride)
+{
+	int i, x, m;
+	size_t l;
+	a->n = n, a->max_len = 0;
+	for (i = 0; i < n; ++i)
+		a->max_len = a->max_len > (int)s[i*stride].l_seq? a->max_len : s[i*stride].l_seq;
+	m = (a->max_len + 15) & ~15; // columns are written 16 at a time
+	l = (size_t)m * LT_BATCH;
+	a->seq = (uint8_t*)malloc(l * 2 + (a->max_len + 1) * 2 * sizeof(uint32_t)); // columns past the end of a lane are not read
+	a->qual = a->seq + l;
+	a->in = (uint32_t*)(a->qual + l), a->began = a->in + a->max_len + 1;
+	memset(a->in, 0, (a->max_len + 1) * sizeof(uint32_t));
+	for (i = 0; i < n; ++i) {
+		a->beg[i] = 0, a->end[i] = s[i*stride].l_seq;
+		a->in[s[i*stride].l_seq] |= 1U<<i;
+	}
+	lt_soa_suffix_or(a->in, a->max_len);
+#if defined(__x86_64__) && defined(__GNUC__)
+	{
+		uint8_t pad[16][16];
+		const uint8_t *rs[16], *rq[16];
+		int h, r;
+		for (h = 0; h < LT_BATCH; h += 16) {
+			for (x = 0; x < m; x += 16) {
+				for (r = 0; r < 16; ++r) {
+					const bseq1_t *p = &s[(h + r) * stride];
+					if (h + r < n && (int)p->l_seq >= x + 16) { // otherwise the read may end inside the block; the tail is left undefined
+						rs[r] = (const uint8_t*)p->seq + x, rq[r] = (const uint8_t*)p->qual + x;
+						continue;
+					}
+					rs[r] = rq[r] = pad[r];
+				}
+				lt_soa_tr16(rs, a->seq + x * LT_BATCH + h, LT_BATCH);
+				lt_soa_tr16(rq, a->qual + x * LT_BATCH + h, LT_BATCH);
+			}
+		}
+	}
+	for (i = 0; i < n; ++i) { // the last partial block of each read
+		const bseq1_t *p = &s[i*stride];
+		for (x = p->l_seq & ~15; x < (int)p->l_seq; ++x)
+			a->seq[x*LT_BATCH+i] = p->seq[x], a->qual[x*LT_BATCH+i] = p->qual[x];
+	}
+#else
+	for (i = 0; i < n; ++i) {
+		const bseq1_t *p = &s[i*stride];
+		for (x = 0; x < (int)p->l_seq; ++x)
+			a->seq[x*LT_BATCH+i] = p->seq[x], a->qual[x*LT_BATCH+i] = p->qual[x];
+	}
+#endif
+}
+
+// lanes with base _c_ at column _x_
+static inline uint32_t lt_soa_eq(const lt_soa_t *a, int x, int c)
+{
+	const uint8_t *p = a->seq + x * LT_BATCH;
+#if defined(__x86_64__) && defined(__GNUC__)
+	const __m128i v = _mm_set1_epi8(c);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), v))
+		| (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 16)), v)) << 16;
+#else
+	uint32_t m = 0;
+	int i;
+	for (i = 0; i < LT_BATCH; ++i)
+		if (p[i] == c) m |= 1U<<i;
+	return m;
+#endif
+}
+
+// trim heading and trailing N of all lanes; in[] and began[] are updated for the trimmed lanes
+static void lt_soa_ntrim(lt_soa_t *a)
+{
+	uint32_t tail = a->in[0], lead, m;
+	int i, x;
+	for (x = a->max_len - 1; x >= 0 && tail; --x) { // tail: lanes whose last non-N base is not found yet
+		m = tail & a->in[x] & ~lt_soa_eq(a, x, 'N');
+		for (tail &= ~m; m; m &= m - 1)
+			a->end[__builtin_ctz(m)] = x + 1;
+	}
+	for (; tail; tail &= tail - 1) a->end[__builtin_ctz(tail)] = 0; // all N
+	for (i = 0; i <= a->max_len; ++i) a->in[i] = 0;
+	for (i = 0, lead = 0; i < a->n; ++i) {
+		a->in[a->end[i]] |= 1U<<i;
+		if (a->end[i] > 0) lead |= 1U<<i;
+	}
+	lt_soa_suffix_or(a->in, a->max_len);
+	for (x = 0; lead; ++x) { // there is a non-N base before end[i], so the loop stops
+		m = lead & ~lt_soa_eq(a, x, 'N');
+		for (lead &= ~m; m; m &= m - 1)
+			a->beg[__builtin_ctz(m)] = x;
+	}
+	memset(a->began, 0, (a->max_len + 1) * sizeof(uint32_t));
+	for (i = 0; i < a->n; ++i) a->began[a->beg[i]] |= 1U<<i;
+	for (x = 1; x <= a->max_len; ++x) a->began[x] |= a->began[x-1];
+}
+
+// record a hit of length _l_ at column _p_ for the lanes in _m_; lanes with _max_pos_ hits leave _need_
+static inline void lt_soa_hit(const lt_soa_t *a, uint32_t m, int p, int l, int max_pos, int *n_hits, uint64_t *hits, uint32_t *need)
+{
+	for (; m; m &= m - 1) {
+		int i = __builtin_ctz(m);
+		hits[i * max_pos + n_hits[i]++] = (uint64_t)(p - a->beg[i]) << 32 | l;
+		if (n_hits[i] == max_pos) *need &= ~(1U<<i);
+	}
+}
+
+// lanes that may have a hit: long enough; return the max start column, or -1 if none
+static int lt_soa_adap_init(const lt_soa_t *a, int l2, int min_len, int *n_hits, uint32_t *need)
+{
+	int i, p_max = -1;
+	*need = 0;
+	for (i = 0; i < a->n; ++i) {
+		n_hits[i] = 0;
+		if (a->end[i] - a->beg[i] >= min_len && l2 >= min_len) {
+			*need |= 1U<<i;
+			p_max = p_max > a->end[i] - min_len? p_max : a->end[i] - min_len;
+		}
+	}
+	return p_max;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+/* lt_ue_for_bp() on every lane at once, for a query without qualities. For each start column p, from right to
+ * left, we extend s2 over the lanes that may start a hit at p; a lane leaves the extension when it triggers the
+ * early-exit rule or reaches its end, the latter being a hit. The penalties are bytes; the caller makes sure
+ * they can't overflow before the exit rule fires. */
+static void lt_soa_adap_sse2(const lt_soa_t *a, int l2, const char *s2, int max_pen, int min_len, int max_pos, int *n_hits, uint64_t *hits)
+{
+	const __m128i lo = _mm_set1_epi8(LT_LOW_PEN), hi = _mm_set1_epi8(LT_HIGH_PEN), thres = _mm_set1_epi8(LT_QUAL_THRES - 1);
+	uint32_t need;
+	int j, p;
+	p = lt_soa_adap_init(a, l2, min_len, n_hits, &need);
+	for (; p >= 0 && need; --p) {
+		uint32_t alive = need & a->in[p + min_len - 1] & a->began[p];
+		__m128i pen0 = _mm_setzero_si128(), pen1 = _mm_setzero_si128();
+		for (j = 0; j < l2 && alive; ++j) {
+			int x = p + j, t = j * max_pen / min_len > max_pen? j * max_pen / min_len : max_pen;
+			uint32_t ended = x < a->max_len? alive & ~a->in[x] : alive, die;
+			const uint8_t *sx = a->seq + x * LT_BATCH, *qx = a->qual + x * LT_BATCH;
+			__m128i c, tv, eq0, eq1, hq0, hq1;
+			if (ended) {
+				lt_soa_hit(a, ended, p, j, max_pos, n_hits, hits, &need);
+				if ((alive &= ~ended) == 0) break;
+			}
+			c = _mm_set1_epi8(s2[j]), tv = _mm_set1_epi8(t);
+			eq0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)sx), c);
+			eq1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(sx + 16)), c);
+			if ((_mm_movemask_epi8(eq0) | (uint32_t)_mm_movemask_epi8(eq1) << 16 | ~alive) == 0xffffffffU) continue;
+			hq0 = _mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*)qx), thres);
+			hq1 = _mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*)(qx + 16)), thres);
+			pen0 = _mm_add_epi8(pen0, _mm_andnot_si128(eq0, _mm_or_si128(_mm_and_si128(hq0, hi), _mm_andnot_si128(hq0, lo))));
+			pen1 = _mm_add_epi8(pen1, _mm_andnot_si128(eq1, _mm_or_si128(_mm_and_si128(hq1, hi), _mm_andnot_si128(hq1, lo))));
+			die = _mm_movemask_epi8(_mm_andnot_si128(eq0, _mm_cmpgt_epi8(pen0, tv)))
+				| (uint32_t)_mm_movemask_epi8(_mm_andnot_si128(eq1, _mm_cmpgt_epi8(pen1, tv))) << 16;
+			alive &= ~die;
+		}
+		if (j == l2 && alive) lt_soa_hit(a, alive, p, l2, max_pos, n_hits, hits, &need); // the whole query matches
+	}
+}
+
+__attribute__((target("avx2")))
+static void lt_soa_adap_avx2(const lt_soa_t *a, int l2, const char *s2, int max_pen, int min_len, int max_pos, int *n_hits, uint64_t *hits)
+{
+	const __m256i lo = _mm256_set1_epi8(LT_LOW_PEN), hi = _mm256_set1_epi8(LT_HIGH_PEN), thres = _mm256_set1_epi8(LT_QUAL_THRES - 1);
+	uint32_t need;
+	int j, p;
+	p = lt_soa_adap_init(a, l2, min_len, n_hits, &need);
+	for (; p >= 0 && need; --p) {
+		uint32_t alive = need & a->in[p + min_len - 1] & a->began[p];
+		__m256i pen = _mm256_setzero_si256();
+		for (j = 0; j < l2 && alive; ++j) {
+			int x = p + j, t = j * max_pen / min_len > max_pen? j * max_pen / min_len : max_pen;
+			uint32_t ended = x < a->max_len? alive & ~a->in[x] : alive;
+			__m256i eq, hq;
+			if (ended) {
+				lt_soa_hit(a, ended, p, j, max_pos, n_hits, hits, &need);
+				if ((alive &= ~ended) == 0) break;
+			}
+			eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(a->seq + x * LT_BATCH)), _mm256_set1_epi8(s2[j]));
+			if (((uint32_t)_mm256_movemask_epi8(eq) | ~alive) == 0xffffffffU) continue;
+			hq = _mm256_cmpgt_epi8(_mm256_loadu_si256((const __m256i*)(a->qual + x * LT_BATCH)), thres);
+			pen = _mm256_add_epi8(pen, _mm256_andnot_si256(eq, _mm256_blendv_epi8(lo, hi, hq)));
+			alive &= ~(uint32_t)_mm256_movemask_epi8(_mm256_andnot_si256(eq, _mm256_cmpgt_epi8(pen, _mm256_set1_epi8(t))));
+		}
+		if (j == l2 && alive) lt_soa_hit(a, alive, p, l2, max_pos, n_hits, hits, &need);
+	}
+}
+#endif
+
+// lt_trim_ends() on _n_ <= LT_BATCH pairs at once
+static void lt_batch_trim_ends(const lt_global_t *g, int n, bseq1_t *s, lt_stats_t *st)
+{
+	int i, k, n_hits[LT_BATCH];
+	uint64_t hits[LT_BATCH * 4];
+	double t = 0.0, t1;
+	if (st) {
+		st->n_pairs += n;
+		for (i = 0; i < n<<1; ++i) st->n_bases_in += s[i].l_seq;
+	}
+	if (!lt_simd) { // no vector kernels; trim pair by pair
+		for (i = 0; i < n; ++i) lt_trim_ends(g, &s[i<<1], st);
+		return;
+	}
+	for (k = 0; k < 2; ++k) {
+		const char *adap = k == 0? lt_adapter1 : lt_adapter2;
+		int l2 = strlen(adap), t_max, max_pen = g->opt.max_adap_pen, min_len = g->opt.min_adap_len;
+		lt_soa_t a;
+		if (st) t = lt_realtime();
+		lt_soa_init(&a, n, s + k, 2);
+		lt_soa_ntrim(&a);
+		for (i = 0; i < n; ++i) { // apply N-trimming to the reads
+			bseq1_t *p = &s[i<<1|k];
+			p->l_seq = a.end[i];
+			p->seq[p->l_seq] = p->qual[p->l_seq] = 0;
+			if (a.beg[i]) trim_bseq_5(p, a.beg[i]);
+		}
+		if (st) t1 = lt_realtime(), st->t_sub[LT_SUB_NTRIM] += t1 - t, t = t1;
+		for (i = 0; i < l2; ++i)
+			if (lt_nt4_table[(uint8_t)adap[i]] > 3) break;
+		t_max = (l2 - 1) * max_pen / min_len > max_pen? (l2 - 1) * max_pen / min_len : max_pen;
+		if (i < l2 || t_max + LT_HIGH_PEN > 127) { // the byte penalties may overflow; fall back to lt_ue_for_bp()
+			for (i = 0; i < n; ++i)
+				n_hits[i] = trim_adap(&s[i<<1|k], adap, 0, min_len, max_pen, 1);
+		} else {
+#if defined(__x86_64__) && defined(__GNUC__)
+			if (lt_simd >= 2) lt_soa_adap_avx2(&a, l2, adap, max_pen, min_len, 4, n_hits, hits);
+			else lt_soa_adap_sse2(&a, l2, adap, max_pen, min_len, 4, n_hits, hits);
+#endif
+			for (i = 0; i < n; ++i)
+				n_hits[i] = trim_adap_hits(&s[i<<1|k], 0, min_len, 1, n_hits[i], &hits[i * 4]);
+		}
+		if (st) {
+			for (i = 0; i < n; ++i) st->n_adap[k] += n_hits[i];
+			st->t_sub[LT_SUB_ADAP] += lt_realtime() - t;
+		}
+		free(a.seq);
+	}
+}
+
+/*********************
+ * Output formatting *
+ *********************/
+
+// append the output of a processed pair to _out_; without _merged_, skip the merge positions. Return
+// the number of bases written.
+static int lt_format_pair(const lt_opt_t *opt, const bseq1_t s[2], int merged, kstring_t *out)
+{
+	int k, n_bases = 0;
+	if (opt->tab_out) { // tabular output
+		kputs(s[0].name, out);
+		kputc('\t', out); kputw(s[0].type, out);
+		if (merged) {
+			kputc('\t', out); kputw(s[0].merge_pos_l, out);
+			kputc('\t', out); kputw(s[0].merge_pos_r, out);
+		}
+		kputc('\t', out); kputw(s[0].olig_pos_f, out);
+		kputc('\t', out); kputw(s[0].olig_pos_r, out);
+		kputc('\t', out); kputw(strlen(s[0].seq), out);
+		kputc('\t', out); kputw(strlen(s[1].seq), out);
+		kputc('\n', out);
+		return 0;
+	}
+	for (k = 0; k < 2; ++k) { // FASTQ output (FASTA not supported yet)
+		const bseq1_t *p = &s[k];
+		if (p->l_seq > 0 && (p->type == LT_NO_MERGE || p->type == LT_MERGE_AMBIGUOUS || p->type == LT_MERGE_PARTIAL || p->type == LT_MERGE_COMPLETE || p->type == LT_MERGE_COMPLETE_FH || p->type == LT_MERGE_COMPLETE_RH || p->type == LT_MERGE_COMPLETE_CH || (p->type == LT_SHORT_PE && k == 0)) ) {
+			kputc(p->qual? '@' : '>', out); kputs(p->name, out);
+			if (p->type == LT_NO_MERGE || p->type == LT_MERGE_AMBIGUOUS) {
+				kputc('/', out); kputc("12"[k], out);
+			}
+			kputs(" YT:i:", out); kputw(p->type, out);
+			if (merged) {
+				kputs("\tML:i:", out); kputw(p->merge_pos_l, out);
+				kputs("\tMR:i:", out); kputw(p->merge_pos_r, out);
+			}
+			kputs("\tBC:Z:", out); kputs(p->bc_cat? p->bc_cat : "*", out);
+			if (p->cell >= 0) { kputs("\tXC:i:", out); kputw(p->cell, out); }
+			kputs("\tPF:i:", out); kputw(p->olig_pos_f, out);
+			kputs("\tPR:i:", out); kputw(p->olig_pos_r, out);
+			if (p->bc_f) { kputs("\tBF:Z:", out); kputs(p->bc_f[0] == 0? "*" : p->bc_f, out); }
+			if (p->bc_r) { kputs("\tBR:Z:", out); kputs(p->bc_r[0] == 0? "*" : p->bc_r, out); }
+			kputc('\n', out);
+			kputs(p->seq, out); kputc('\n', out);
+			if (p->qual) { kputsn("+\n", 2, out); kputs(p->qual, out); kputc('\n', out); }
+			n_bases += p->l_seq;
+		}
+	}
+	return n_bases;
+}
+
+/*********************
+ * Binary QC columns *
+ *********************/
+
+/* With -Q, each pair gets a row in a columnar file that can be memory-mapped for analysis. The file starts
+ * with the 8 bytes "LTQC\1\0\0\0", followed by one record per chunk: a 16-byte header (uint32 LT_QC_MAGIC,
+ * uint32 number of pairs n, uint64 0-based index of the first pair in the input), then n int32 for each
+ * column of lt_qc_col_e in order, n uint8 pair types and padding to a multiple of 8 bytes. Barcode and cell
+ * ids are -1 when absent and len2 is 0 for merged pairs. Integers are in the native byte order; a reader
+ * can tell the order from LT_QC_MAGIC. */
+
+#define LT_QC_MAGIC 0x4b51544cU // "LTQK" on little-endian machines
+
+enum lt_qc_col_e { // merge_pos_l, merge_pos_r, olig_pos_f, olig_pos_r, len1, len2, bc_id_f, bc_id_r, cell
+	LT_QC_MERGE_L = 0, LT_QC_MERGE_R, LT_QC_OLIG_F, LT_QC_OLIG_R, LT_QC_LEN1, LT_QC_LEN2, LT_QC_BC_F, LT_QC_BC_R, LT_QC_CELL, LT_QC_N_I32
+};
+
+typedef struct {
+	int n;
+	int32_t *i32[LT_QC_N_I32];
+	uint8_t *type;
+	size_t len; // bytes in buf, header and padding included
+	uint8_t *buf;
+} lt_qc_t;
+
+static void lt_qc_init(lt_qc_t *q, int n, int64_t first)
+{
+	uint32_t h[2];
+	int k;
+	q->n = n;
+	q->len = (16 + (size_t)n * (LT_QC_N_I32 * 4 + 1) + 7) & ~(size_t)7;
+	q->buf = (uint8_t*)calloc(q->len, 1);
+	h[0] = LT_QC_MAGIC, h[1] = n;
+	memcpy(q->buf, h, 8);
+	memcpy(q->buf + 8, &first, 8);
+	for (k = 0; k < LT_QC_N_I32; ++k)
+		q->i32[k] = (int32_t*)(q->buf + 16) + (size_t)k * n;
+	q->type = (uint8_t*)(q->i32[0] + (size_t)LT_QC_N_I32 * n);
+}
+
+// fill row _i_ from a processed pair; s[1].l_seq is 0 once the two ends are merged
+static inline void lt_qc_set(lt_qc_t *q, int i, const bseq1_t s[2])
+{
+	q->i32[LT_QC_MERGE_L][i] = s[0].merge_pos_l, q->i32[LT_QC_MERGE_R][i] = s[0].merge_pos_r;
+	q->i32[LT_QC_OLIG_F][i] = s[0].olig_pos_f, q->i32[LT_QC_OLIG_R][i] = s[0].olig_pos_r;
+	q->i32[LT_QC_LEN1][i] = s[0].l_seq, q->i32[LT_QC_LEN2][i] = s[1].l_seq;
+	q->i32[LT_QC_BC_F][i] = s[0].bc_id_f, q->i32[LT_QC_BC_R][i] = s[0].bc_id_r;
+	q->i32[LT_QC_CELL][i] = s[0].cell;
+	q->type[i] = s[0].type;
+}
+
+// open _fn_ and write the file header, or only open it for appending with _append_
+static FILE *lt_qc_open(const char *fn, int append)
+{
+	FILE *fp;
+	if ((fp = fopen(fn, append? "ab" : "wb")) == 0) return 0;
+	if (!append && fwrite("LTQC\1\0\0\0", 1, 8, fp) != 8) {
+		fclose(fp);
+		return 0;
+	}
+	return fp;
+}
+
+/***************
+ * Checkpoints *
+ ***************/
+
+/* With --checkpoint, the outputs are flushed to the disk every --checkpoint-every chunks, right after a
+ * chunk is written, and FILE records the pairs done so far, where the next pair starts in each input and
+ * the size of each output. An input position is a BGZF virtual offset for BGZF input and an offset into the
+ * decompressed stream otherwise; gzseek() gets back to the latter by inflating without processing. With
+ * --resume, the outputs are cut back to the recorded sizes and appended to. FILE is replaced by rename(), so
+ * a run killed at any time leaves a complete checkpoint behind. */
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#define LT_CKPT_MAGIC "LTCK1"
+
+static const char *lt_out_str[] = { "stdout", "bgzf", "unmerged", "reject", "qc" };
+
+typedef struct {
+	int64_t n_pairs;
+	int bgzf[2];  // whether in[i] is a virtual offset
+	int64_t in[2];
+	int64_t out[LT_OUT_N]; // -1 for outputs not in use
+} lt_ckpt_t;
+
+static int lt_ckpt_sync(FILE *fp) // fsync() fails on pipes, which is fine
+{
+	if (fflush(fp) != 0) return -1;
+	fsync(fileno(fp));
+	return 0;
+}
+
+static int lt_ckpt_save(lt_global_t *g, int64_t n_pairs, const int64_t in[2])
+{
+	FILE *fp, *fpo[LT_OUT_N];
+	int64_t out[LT_OUT_N];
+	kstring_t tmp = {0,0,0};
+	int i, ret = 0;
+	fpo[LT_OUT_STDOUT] = g->fpo? 0 : stdout, fpo[LT_OUT_BGZF] = g->fpo? (FILE*)g->fpo->fp : 0;
+	fpo[LT_OUT_UNMERGED] = g->fpu, fpo[LT_OUT_REJECT] = g->fpr, fpo[LT_OUT_QC] = g->fpq;
+	if (g->fpo && (bgzf_flush(g->fpo) != 0 || g->fpo->errcode)) return -1;
+	for (i = 0; i < LT_OUT_N; ++i) {
+		if (fpo[i] && lt_ckpt_sync(fpo[i]) != 0) return -1;
+		out[i] = fpo[i] == 0? -1 : i == LT_OUT_BGZF? ftello(fpo[i]) : g->n_out[i];
+	}
+	ksprintf(&tmp, "%s.tmp", g->fn_ckpt);
+	if ((fp = fopen(tmp.s, "w")) == 0) {
+		free(tmp.s);
+		return -1;
+	}
+	fprintf(fp, "%s\npairs\t%lld\n", LT_CKPT_MAGIC, (long long)n_pairs);
+	fprintf(fp, "in1\t%s\t%lld\n", g->fp->inflate == LT_INFLATE_BGZF? "bgzf" : "raw", (long long)in[0]);
+	if (g->fp2) fprintf(fp, "in2\t%s\t%lld\n", g->fp2->inflate == LT_INFLATE_BGZF? "bgzf" : "raw", (long long)in[1]);
+	else fprintf(fp, "in2\traw\t0\n");
+	for (i = 0; i < LT_OUT_N; ++i)
+		fprintf(fp, "%s\t%lld\n", lt_out_str[i], (long long)out[i]);
+	if (lt_ckpt_sync(fp) != 0) ret = -1;
+	if (fclose(fp) != 0) ret = -1;
+	if (ret == 0 && rename(tmp.s, g->fn_ckpt) != 0) ret = -1;
+	if (ret == 0 && lt_verbose >= 3)
+		fprintf(stderr, "[M::%s] checkpoint after %lld pairs\n", __func__, (long long)n_pairs);
+	free(tmp.s);
+	return ret;
+}
+
+static int lt_ckpt_load(const char *fn, lt_ckpt_t *ck)
+{
+	FILE *fp;
+	char key[16], mode[8];
+	long long x;
+	int i, ret = 0;
+	if ((fp = fopen(fn, "r")) == 0) return -1;
+	if (fscanf(fp, "%15s", key) != 1 || strcmp(key, LT_CKPT_MAGIC) != 0) ret = -1;
+	else if (fscanf(fp, "%15s%lld", key, &x) != 2 || strcmp(key, "pairs") != 0) ret = -1;
+	else ck->n_pairs = x;
+	for (i = 0; i < 2 && ret == 0; ++i) {
+		if (fscanf(fp, "%15s%7s%lld", key, mode, &x) != 3) ret = -1;
+		else ck->bgzf[i] = (strcmp(mode, "bgzf") == 0), ck->in[i] = x;
+	}
+	for (i = 0; i < LT_OUT_N && ret == 0; ++i) {
+		if (fscanf(fp, "%15s%lld", key, &x) != 2 || strcmp(key, lt_out_str[i]) != 0) ret = -1;
+		else ck->out[i] = x;
+	}
+	fclose(fp);
+	return ret;
+}
+
+// cut the output _fn_, or stdout if NULL, back to _size_ bytes; _fn_ is then opened for appending
+static int lt_ckpt_cut(const char *fn, int64_t size)
+{
+	struct stat st;
+	int fd, ret = 0;
+	fd = fn? open(fn, O_WRONLY) : fileno(stdout);
+	if (fd < 0 || fstat(fd, &st) != 0) ret = -1;
+	else if (!S_ISREG(st.st_mode))
+		fprintf(stderr, "[W::%s] '%s' is not a regular file; it only gets the output after the checkpoint\n", __func__, fn? fn : "stdout");
+	else if (st.st_size < size) {
+		fprintf(stderr, "[E::%s] '%s' is shorter than at the checkpoint%s\n", __func__, fn? fn : "stdout", fn? "" : "; redirect stdout with >>");
+		ret = -1;
+	} else if (ftruncate(fd, size) != 0 || (fn == 0 && lseek(fd, size, SEEK_SET) < 0)) ret = -1;
+	if (fn && fd >= 0) close(fd);
+	return ret;
+}
+
+/**********************
+ * Callback functions *
+ **********************/
+
+void kt_pipeline_timed(int n_threads, void *(*func)(void*, int, void*), void *shared_data, int n_steps, double *wait);
+
+typedef struct {
+	int n_seqs;
+	bseq1_t *seqs;
+	lt_global_t *g;
+	char *buf[2]; // input buffers that name/seq/qual point into
+	lt_arena_t *ar; // one arena per kt_for() worker
+	int n_blks;
+	kstring_t *out; // output of pairs [LT_OUT_BLK*i, LT_OUT_BLK*(i+1)) goes to out[i]
+	int *end; // with -o, end[i]: end of pair i in its out[] string
+	int64_t first; // index of the first pair in the input
+	int64_t in_off[2]; // bseq_tell() of the inputs after this chunk
+	lt_qc_t qc; // with -Q
+	bseq1_t *useqs; // unmerged pairs with -U
+	kstring_t *uout;
+	kstring_t *rout; // pairs dropped by --require-bc, with --reject
+	lt_stats_t *st; // one per kt_for() worker, with --stats
+	double t_real[2], t_cpu; // time spent on reading and processing this chunk
+	double t_mem; // time the reader waited for the memory budget before this chunk
+	int64_t mem; // bytes charged to g->mem
+} data_for_t;
+
+#define LT_OUT_BLK 256 // number of pairs processed and formatted by one kt_for() task
+#define LT_BGZF_SUB_BLKS 64 // BGZF blocks compressed by each thread at a time with -o
+
+// write _n_ pairs ending at _end_ in _s_, keeping each pair in one BGZF block so that blocks can be parsed independently
+static void lt_write_bgzf(BGZF *fp, const kstring_t *s, int n, const int *end)
+{
+	int j, st;
+	for (j = 0, st = 0; j < n; st = end[j++]) {
+		int l = end[j] - st;
+		if (l == 0) continue;
+		bgzf_flush_try(fp, l); // starts a new block if the pair does not fit in the current one
+		bgzf_write(fp, s->s + st, l);
+	}
+}
+
+static void worker_for(void *_data, long b, int tid)
+{
+	data_for_t *data = (data_for_t*)_data;
+	int i, end = (b + 1) * LT_OUT_BLK < data->n_seqs>>1? (b + 1) * LT_OUT_BLK : data->n_seqs>>1;
+	lt_stats_t *st = data->st? &data->st[tid] : 0;
+	double t = 0.0, t_cpu = 0.0;
+	if (st) t_cpu = lt_thread_cputime();
+	for (i = b * LT_OUT_BLK; i < end; ++i) {
+		int n, ok;
+		if (!data->g->opt.batch) ok = lt_process(data->g, &data->seqs[i<<1], data->useqs? &data->useqs[i<<1] : 0, &data->ar[tid], st);
+		else {
+			if ((i - b * LT_OUT_BLK) % LT_BATCH == 0) // LT_OUT_BLK is a multiple of LT_BATCH
+				lt_batch_trim_ends(data->g, end - i < LT_BATCH? end - i : LT_BATCH, &data->seqs[i<<1], st);
+			ok = lt_process_trimmed(data->g, &data->seqs[i<<1], data->useqs? &data->useqs[i<<1] : 0, &data->ar[tid], st);
+		}
+		if (st) t = lt_realtime();
+		if (ok) {
+			n = lt_format_pair(&data->g->opt, &data->seqs[i<<1], !data->g->opt.no_merge, &data->out[b]);
+			if (st) st->n_bases_out += n;
+		} else if (data->rout) lt_format_pair(&data->g->opt, &data->seqs[i<<1], 0, &data->rout[b]);
+		if (data->end) data->end[i] = data->out[b].l;
+		if (data->qc.buf) lt_qc_set(&data->qc, i, &data->seqs[i<<1]);
+		if (ok && data->useqs) {
+			n = lt_format_pair(&data->g->opt, &data->useqs[i<<1], 0, &data->uout[b]);
+			if (st) st->n_bases_uout += n;
+		}
+		if (st) st->t_sub[LT_SUB_FORMAT] += lt_realtime() - t;
+	}
+	if (st) st->t_cpu[LT_STEP_PROC] += lt_thread_cputime() - t_cpu;
+}
+
+static void *worker_pipeline(void *shared, int step, void *_data)
+{
+	int i;
+	lt_global_t *g = (lt_global_t*)shared;
+	if (step == 0) {
+		data_for_t *ret;
+		double t_real, t_cpu, t_mem = lt_realtime();
+		t_mem = lt_mem_wait(&g->mem)? lt_realtime() - t_mem : 0.0;
+		t_real = lt_realtime(), t_cpu = lt_thread_cputime();
+		ret = calloc(1, sizeof(data_for_t));
+		ret->seqs = bseq_read(g->fp, g->fp2, g->opt.chunk_size, &ret->n_seqs, ret->buf);
+		assert((ret->n_seqs&1) == 0);
+		ret->t_real[0] = lt_realtime() - t_real, ret->t_cpu = lt_thread_cputime() - t_cpu;
+		ret->t_mem = t_mem;
+		ret->first = g->n_read, g->n_read += ret->n_seqs>>1;
+		ret->g = g;
+		ret->ar = calloc(g->opt.n_threads, sizeof(lt_arena_t));
+		ret->in_off[0] = bseq_tell(g->fp), ret->in_off[1] = g->fp2? bseq_tell(g->fp2) : 0;
+		if (ret->seqs) {
+			ret->mem = g->fp->m + (g->fp2? g->fp2->m : 0) + ret->n_seqs * sizeof(bseq1_t); // the detached buffers are as large as the new ones
+			lt_mem_charge(&g->mem, ret->mem);
+			return ret;
+		}
+		free(ret->ar); free(ret);
+	} else if (step == 1) {
+		data_for_t *data = (data_for_t*)_data;
+		data->n_blks = ((data->n_seqs>>1) + LT_OUT_BLK - 1) / LT_OUT_BLK;
+		data->out = (kstring_t*)calloc(data->n_blks, sizeof(kstring_t));
+		double t = lt_realtime();
+		if (g->fpo) data->end = (int*)malloc((data->n_seqs>>1) * sizeof(int));
+		if (g->fpq) lt_qc_init(&data->qc, data->n_seqs>>1, data->first);
+		if (g->fpu) {
+			data->useqs = (bseq1_t*)malloc(data->n_seqs * sizeof(bseq1_t));
+			data->uout = (kstring_t*)calloc(data->n_blks, sizeof(kstring_t));
+		}
+		if (g->fpr) data->rout = (kstring_t*)calloc(data->n_blks, sizeof(kstring_t));
+		if (g->st) {
+			data->st = (lt_stats_t*)malloc(g->opt.n_threads * sizeof(lt_stats_t));
+			for (i = 0; i < g->opt.n_threads; ++i)
+				lt_stats_init(&data->st[i], g->bi->n);
+		}
+		kt_for(g->opt.n_threads, worker_for, data, data->n_blks);
+		data->t_real[1] = lt_realtime() - t;
+		{ // charge the processing memory
+			int64_t m = 0;
+			for (i = 0; i < data->n_blks; ++i)
+				m += data->out[i].m + (data->uout? data->uout[i].m : 0) + (data->rout? data->rout[i].m : 0);
+			for (i = 0; i < g->opt.n_threads; ++i)
+				m += lt_arena_capacity(&data->ar[i]);
+			if (data->useqs) m += data->n_seqs * sizeof(bseq1_t);
+			if (data->end) m += (data->n_seqs>>1) * sizeof(int);
+			m += data->qc.len;
+			lt_mem_charge(&g->mem, m);
+			data->mem += m;
+		}
+		return data;
+	} else if (step == 2) {
+		data_for_t *data = (data_for_t*)_data;
+		double t_real = lt_realtime(), t_cpu = lt_thread_cputime();
+		for (i = 0; i < data->n_blks; ++i) {
+			if (g->fpo) {
+				int n = (i + 1) * LT_OUT_BLK < data->n_seqs>>1? LT_OUT_BLK : (data->n_seqs>>1) - i * LT_OUT_BLK;
+				lt_write_bgzf(g->fpo, &data->out[i], n, &data->end[i * LT_OUT_BLK]);
+			} else if (data->out[i].l) fwrite(data->out[i].s, 1, data->out[i].l, stdout), g->n_out[LT_OUT_STDOUT] += data->out[i].l;
+			free(data->out[i].s);
+			if (data->uout) {
+				if (data->uout[i].l) fwrite(data->uout[i].s, 1, data->uout[i].l, g->fpu), g->n_out[LT_OUT_UNMERGED] += data->uout[i].l;
+				free(data->uout[i].s);
+			}
+			if (data->rout) {
+				if (data->rout[i].l) fwrite(data->rout[i].s, 1, data->rout[i].l, g->fpr), g->n_out[LT_OUT_REJECT] += data->rout[i].l;
+				free(data->rout[i].s);
+			}
+		}
+		if (data->qc.buf) {
+			if (fwrite(data->qc.buf, 1, data->qc.len, g->fpq) != data->qc.len) g->qc_err = 1;
+			g->n_out[LT_OUT_QC] += data->qc.len;
+		}
+		if (lt_verbose >= 3) {
+			size_t n_alloc = 0, cap = 0;
+			for (i = 0; i < g->opt.n_threads; ++i)
+				n_alloc += data->ar[i].n_alloc, cap += lt_arena_capacity(&data->ar[i]);
+			fprintf(stderr, "[M::%s] processed %d sequences; %.1f MB input buffer; %.1f MB allocated in %.1f MB of arena blocks\n", __func__,
+					data->n_seqs, (g->fp->m + (g->fp2? g->fp2->m : 0)) / 1048576., n_alloc / 1048576., cap / 1048576.);
+		}
+		++g->n_chunks;
+		if (g->fn_ckpt && g->n_chunks % g->opt.ckpt_every == 0 && lt_ckpt_save(g, data->first + (data->n_seqs>>1), data->in_off) != 0)
+			fprintf(stderr, "[W::%s] failed to write the checkpoint to '%s'\n", __func__, g->fn_ckpt);
+		if (g->st) {
+			lt_stats_t *st = g->st;
+			for (i = 0; i < g->opt.n_threads; ++i) {
+				lt_stats_add(st, &data->st[i], g->bi->n);
+				free(data->st[i].n_bc);
+			}
+			st->t_real[LT_STEP_READ] += data->t_real[0], st->t_cpu[LT_STEP_READ] += data->t_cpu;
+			st->t_real[LT_STEP_PROC] += data->t_real[1];
+			st->t_real[LT_STEP_OUT] += lt_realtime() - t_real, st->t_cpu[LT_STEP_OUT] += lt_thread_cputime() - t_cpu;
+			if (g->opt.stats_every > 0 && g->n_chunks % g->opt.stats_every == 0 && lt_stats_write(g->fn_stats, st, g->bi, g->fpu != 0, g->n_chunks, 0, g->t_start, g->wait, &g->mem, g->cells? g->cells->n : 0) != 0)
+				fprintf(stderr, "[W::%s] failed to write statistics to '%s'\n", __func__, g->fn_stats);
+		}
+		for (i = 0; i < g->opt.n_threads; ++i) // deallocate
+			lt_arena_destroy(&data->ar[i]);
+		g->mem.t_blocked += data->t_mem;
+		lt_mem_release(&g->mem, data->mem);
+		free(data->st); free(data->ar); free(data->out); free(data->end); free(data->qc.buf); free(data->useqs); free(data->uout); free(data->rout); free(data->buf[0]); free(data->buf[1]); free(data->seqs); free(data);
+	}
+	return 0;
+}
+
+#include <getopt.h>
+
+static struct option lt_long_opts[] = {
+	{ "stats",       required_argument, 0, 300 },
+	{ "stats-every", required_argument, 0, 301 },
+	{ "require-bc",  no_argument,       0, 302 },
+	{ "reject",      required_argument, 0, 303 },
+	{ "checkpoint",  required_argument, 0, 304 },
+	{ "checkpoint-every", required_argument, 0, 305 },
+	{ "resume",      no_argument,       0, 306 },
+	{ "shard",       required_argument, 0, 307 },
+	{ 0, 0, 0, 0 }
+};
+
+int main(int argc, char *argv[])
+{
+	int c, i, resume = 0, inflate[2], shard = -1, n_shards = 0;
+	lt_global_t g;
+	lt_ckpt_t ck;
+	char *fn_bc = 0, *fn_u = 0, *fn_cells = 0, *fn_rg = 0, *fn_out = 0, *fn_qc = 0, *fn_rej = 0;
+	int64_t budget = 0;
+
+	lt_global_init(&g);
+	lt_simd_init();
+	g.t_start = lt_realtime();
+	while ((c = getopt_long(argc, argv, "TSMEt:b:l:c:q:v:z:X:p:U:r:m:R:H:o:Q:", lt_long_opts, 0)) >= 0) {
+		if (c == 't') g.opt.n_threads = atoi(optarg);
+		else if (c == 'r') g.opt.bc_rescue = atoi(optarg);
+		else if (c == 300) g.fn_stats = optarg;
+		else if (c == 301) g.opt.stats_every = atoi(optarg);
+		else if (c == 302) g.opt.require_bc = 1;
+		else if (c == 303) fn_rej = optarg;
+		else if (c == 304) g.fn_ckpt = optarg;
+		else if (c == 305) g.opt.ckpt_every = atoi(optarg) > 1? atoi(optarg) : 1;
+		else if (c == 306) resume = 1;
+		else if (c == 307) {
+			if (sscanf(optarg, "%d/%d", &shard, &n_shards) != 2 || shard < 0 || shard >= n_shards) {
+				fprintf(stderr, "[E::%s] --shard expects i/N with 0 <= i < N\n", __func__);
+				return 1;
+			}
+		}
+		else if (c == 'p') g.opt.n_inflight = atoi(optarg) > 2? atoi(optarg) : 2;
+		else if (c == 'm') {
+			if ((budget = lt_parse_size(optarg)) == 0) {
+				fprintf(stderr, "[E::%s] invalid memory budget '%s'\n", __func__, optarg);
+				return 1;
+			}
+		}
+		else if (c == 'S') lt_simd = 0;
+		else if (c == 'E') g.opt.batch = 1;
+		else if (c == 'b') fn_bc = optarg;
+		else if (c == 'U') fn_u = optarg;
+		else if (c == 'o') fn_out = optarg;
+		else if (c == 'Q') fn_qc = optarg;
+		else if (c == 'R') fn_cells = optarg;
+		else if (c == 'H') fn_rg = optarg;
+		else if (c == 'M') g.opt.no_merge = 1;
+		else if (c == 'X') {
+			if (strcmp(optarg, "exact") == 0) g.opt.merge_exact = 1;
+			else if (strcmp(optarg, "packed") == 0) g.opt.merge_exact = 0;
+			else {
+				fprintf(stderr, "[E::%s] unknown overlap search '%s'\n", __func__, optarg);
+				return 1;
+			}
+		}
 		else if (c == 'T') g.opt.tab_out = 1;
 		else if (c == 'l') g.opt.min_seq_len = atoi(optarg);
 		else if (c == 'c') g.opt.bc_cut = atoi(optarg);
 		else if (c == 'q') g.opt.qmask = atoi(optarg);
+		else if (c == 'v') lt_verbose = atoi(optarg);
+		else if (c == 'z') {
+			for (i = 0; i < 4; ++i)
+				if (strcmp(optarg, lt_inflate_str[i]) == 0) break;
+			if (i == 4) {
+				fprintf(stderr, "[E::%s] unknown decompression mode '%s'\n", __func__, optarg);
+				return 1;
+			}
+			g.opt.inflate = i;
+		}
 	}
 	if (argc - optind < 1) {
-		fprintf(stderr, "Usage: seqtk mergepe <read1.fq> <read2.fq> | preprocess [options] -\n");
+		for (i = 0; Tn5_barcode[i]; ++i);
+		fprintf(stderr, "Usage: preprocess [options] <in.fq> [in2.fq]\n");
 		fprintf(stderr, "Options:\n");
 		fprintf(stderr, "  -t INT     number of threads [%d]\n", g.opt.n_threads);
+		fprintf(stderr, "  -p INT     number of chunks in flight between reading, processing and writing [%d]\n", g.opt.n_inflight);
+		fprintf(stderr, "  -m SIZE    memory budget for the chunks in flight, e.g. 2G; sizes the chunks and -p, and blocks reading [unlimited]\n");
 		fprintf(stderr, "  -l INT     min read/fragment length to output [%d]\n", g.opt.min_seq_len);
+		fprintf(stderr, "  -b FILE    Tn5 barcodes as they appear in reads, one per line; FWD-REV pairs are split [built-in %d]\n", i);
 		fprintf(stderr, "  -c INT     cut INT-bp from the 5'-end to derive concatenated BC [%d]\n", g.opt.bc_cut);
+		fprintf(stderr, "  -r INT     rescue 5'-barcodes with up to INT mismatches in barcode+transposon, max %d [%d]\n", LT_BCR_MAX_DIST, g.opt.bc_rescue);
+		fprintf(stderr, "  -R FILE    barcode pairs FWD-REV, one per line; tag pairs with the 0-based line as XC:i\n");
+		fprintf(stderr, "  -H FILE    with -R, write one @RG line per cell, with the XC:i value as ID, to FILE\n");
 		fprintf(stderr, "  -q INT     if both qualities on an overlap base above INT, mask to N [%d]\n", g.opt.qmask);
+		fprintf(stderr, "  -z STR     decompression: serial, thread (read-ahead thread), bgzf (parallel inflate) or auto [%s]\n", lt_inflate_str[g.opt.inflate]);
+		fprintf(stderr, "  -v INT     verbose level [%d]\n", lt_verbose);
+		fprintf(stderr, "  -o FILE    write BGZF-compressed output to FILE, with -t threads compressing [stdout]\n");
+		fprintf(stderr, "  -U FILE    also write unmerged pairs, as with -M, to FILE\n");
+		fprintf(stderr, "  -M         do not merge the two ends\n");
+		fprintf(stderr, "  -X STR     overlap search for merging: packed (XOR/popcount prefilter) or exact [%s]\n", g.opt.merge_exact? "exact" : "packed");
+		fprintf(stderr, "  -S         use the scalar extension kernels only\n");
+		fprintf(stderr, "  -E         trim N and adapters on %d pairs at a time with the vectorized batch engine\n", LT_BATCH);
 		fprintf(stderr, "  -T         tabular output for debugging\n");
+		fprintf(stderr, "  -Q FILE    write the type, merge/transposon positions, lengths, barcode and cell ids of every pair as binary columns to FILE\n");
+		fprintf(stderr, "  --stats FILE       write run statistics and per-stage timing as JSON to FILE at exit\n");
+		fprintf(stderr, "  --stats-every INT  also update the statistics every INT chunks [0]\n");
+		fprintf(stderr, "  --require-bc       drop pairs without a barcode at both ends before merging\n");
+		fprintf(stderr, "  --reject FILE      with --require-bc, write the dropped pairs, as with -M, to FILE\n");
+		fprintf(stderr, "  --checkpoint FILE  record where to resume in FILE every --checkpoint-every chunks\n");
+		fprintf(stderr, "  --checkpoint-every INT  chunks between checkpoints [%d]\n", g.opt.ckpt_every);
+		fprintf(stderr, "  --resume           resume from the --checkpoint FILE with the same options, appending to the\n");
+		fprintf(stderr, "                     outputs; redirect stdout with >>; --stats only covers the resumed part\n");
+		fprintf(stderr, "  --shard i/N        only process the i-th (0-based) of N slices of BGZF input; the outputs of\n");
+		fprintf(stderr, "                     the N slices concatenate to the whole output; -Q pair indices start at 0 in each\n");
+		fprintf(stderr, "Note: with one input file, reads are expected to be interleaved; use \"-\" for stdin\n");
+		return 1;
+	}
+
+	if (fn_bc) {
+		if ((g.bi = lt_bcidx_load(fn_bc)) == 0) {
+			fprintf(stderr, "[E::%s] failed to load barcodes from '%s'\n", __func__, fn_bc);
+			return 1;
+		}
+	} else {
+		for (i = 0; Tn5_barcode[i]; ++i);
+		g.bi = lt_bcidx_init(i, Tn5_barcode);
+	}
+	if (budget > 0) {
+		lt_mem_fit(&g.opt, budget);
+		if (lt_verbose >= 3)
+			fprintf(stderr, "[M::%s] up to %d chunks of %d bases in flight for a %.1f MB budget\n", __func__, g.opt.n_inflight, g.opt.chunk_size, budget / 1048576.);
+	}
+	lt_mem_init(&g.mem, budget, &g.opt);
+	g.cons = lt_cons_init(&g.opt);
+	g.gen = lt_gen_check(g.bi, &g.opt);
+	if (lt_verbose >= 3)
+		fprintf(stderr, "[M::%s] indexed %d barcodes into %d automaton states; %s barcode scan, %s adapter search\n", __func__, g.bi->n, g.bi->n_nodes,
+				g.gen & LT_GEN_BC? "generated" : "generic", g.gen & LT_GEN_ADAP? "generated" : "generic");
+	if (g.opt.bc_rescue > 0) {
+		if (g.opt.bc_rescue > LT_BCR_MAX_DIST) {
+			fprintf(stderr, "[E::%s] -r can't be larger than %d\n", __func__, LT_BCR_MAX_DIST);
+			return 1;
+		}
+		g.br = lt_bcres_init(g.bi, lt_oligo_for, g.opt.bc_rescue);
+		if (lt_verbose >= 3)
+			fprintf(stderr, "[M::%s] indexed %lld barcode+transposon variants within %d mismatches; %lld are ambiguous\n", __func__,
+					(long long)g.br->n_var, g.opt.bc_rescue, (long long)g.br->n_ambi);
+	}
+
+	if (fn_rej && !g.opt.require_bc) {
+		fprintf(stderr, "[E::%s] --reject requires --require-bc\n", __func__);
+		return 1;
+	}
+	if (resume && shard >= 0) {
+		fprintf(stderr, "[E::%s] --resume can't be used with --shard\n", __func__);
+		return 1;
+	}
+	if (resume) {
+		int use[LT_OUT_N];
+		if (g.fn_ckpt == 0) {
+			fprintf(stderr, "[E::%s] --resume requires --checkpoint\n", __func__);
+			return 1;
+		}
+		if (lt_ckpt_load(g.fn_ckpt, &ck) != 0) {
+			fprintf(stderr, "[E::%s] failed to read the checkpoint from '%s'\n", __func__, g.fn_ckpt);
+			return 1;
+		}
+		use[LT_OUT_STDOUT] = !fn_out, use[LT_OUT_BGZF] = !!fn_out, use[LT_OUT_UNMERGED] = !!fn_u, use[LT_OUT_REJECT] = !!fn_rej, use[LT_OUT_QC] = !!fn_qc;
+		for (i = 0; i < LT_OUT_N; ++i)
+			if (use[i] != (ck.out[i] >= 0)) {
+				fprintf(stderr, "[E::%s] the %s output is %sin use at the checkpoint\n", __func__, lt_out_str[i], use[i]? "not " : "");
+				return 1;
+			}
+		for (i = 0; i < LT_OUT_N; ++i) {
+			const char *fn = i == LT_OUT_BGZF? fn_out : i == LT_OUT_UNMERGED? fn_u : i == LT_OUT_REJECT? fn_rej : i == LT_OUT_QC? fn_qc : 0;
+			if (use[i] && lt_ckpt_cut(fn, ck.out[i]) != 0) {
+				fprintf(stderr, "[E::%s] failed to cut '%s' back to the checkpoint\n", __func__, fn? fn : "stdout");
+				return 1;
+			}
+			g.n_out[i] = ck.out[i];
+		}
+		g.n_read = ck.n_pairs;
+		if (lt_verbose >= 3)
+			fprintf(stderr, "[M::%s] resuming after %lld pairs\n", __func__, (long long)ck.n_pairs);
+	} else g.n_out[LT_OUT_QC] = 8; // the file header
+	for (i = 0; i < 2; ++i) // on resume, positions must be read the way they were recorded
+		inflate[i] = !resume? g.opt.inflate : ck.bgzf[i]? LT_INFLATE_BGZF : g.opt.inflate == LT_INFLATE_SERIAL? LT_INFLATE_SERIAL : LT_INFLATE_THREAD;
+
+	if (fn_rg && !fn_cells) {
+		fprintf(stderr, "[E::%s] -H requires -R\n", __func__);
+		return 1;
+	}
+	if (fn_cells) {
+		if ((g.cells = lt_cells_load(fn_cells)) == 0) {
+			fprintf(stderr, "[E::%s] failed to load barcode pairs from '%s'\n", __func__, fn_cells);
+			return 1;
+		}
+		if (lt_verbose >= 3)
+			fprintf(stderr, "[M::%s] hashed %d barcode pairs into %d slots\n", __func__, g.cells->n, 1<<g.cells->bits);
+		if (fn_rg && lt_cells_write_rg(g.cells, fn_rg) != 0) {
+			fprintf(stderr, "[E::%s] failed to write the read groups to '%s'\n", __func__, fn_rg);
+			return 1;
+		}
+	}
+
+	if (shard >= 0) {
+		if (lt_shard_init(argv[optind], optind + 1 < argc? argv[optind + 1] : 0, shard, n_shards, g.opt.n_threads, &g.fp, &g.fp2) != 0) {
+			fprintf(stderr, "[E::%s] failed to open shard %d of %d\n", __func__, shard, n_shards);
+			return 1;
+		}
+	} else g.fp = bseq_open(argv[optind], inflate[0], g.opt.n_threads, resume? ck.in[0] : 0);
+	if (g.fp == 0) {
+		fprintf(stderr, "[E::%s] failed to open file '%s'\n", __func__, argv[optind]);
+		return 1;
+	}
+	if (optind + 1 < argc && g.fp2 == 0) {
+		g.fp2 = bseq_open(argv[optind + 1], inflate[1], g.opt.n_threads, resume? ck.in[1] : 0);
+		if (g.fp2 == 0) {
+			fprintf(stderr, "[E::%s] failed to open file '%s'\n", __func__, argv[optind + 1]);
+			return 1;
+		}
+	}
+
+	if (lt_verbose >= 3) {
+		fprintf(stderr, "[M::%s] using the %s extension kernels\n", __func__, lt_simd == 2? "AVX2" : lt_simd == 1? "SSE2" : "scalar");
+		fprintf(stderr, "[M::%s] decompressing '%s' in the '%s' mode\n", __func__, argv[optind], lt_inflate_str[g.fp->inflate]);
+		if (g.fp2) fprintf(stderr, "[M::%s] decompressing '%s' in the '%s' mode\n", __func__, argv[optind + 1], lt_inflate_str[g.fp2->inflate]);
+	}
+
+	if (fn_u && (g.fpu = fopen(fn_u, resume? "a" : "w")) == 0) {
+		fprintf(stderr, "[E::%s] failed to open file '%s' for writing\n", __func__, fn_u);
+		return 1;
+	}
+	if (fn_out) {
+		if ((g.fpo = bgzf_open(fn_out, resume? "a" : "w")) == 0) {
+			fprintf(stderr, "[E::%s] failed to open file '%s' for writing\n", __func__, fn_out);
+			return 1;
+		}
+		if (g.opt.n_threads > 1) bgzf_mt(g.fpo, g.opt.n_threads, LT_BGZF_SUB_BLKS);
+	}
+	if (fn_rej && (g.fpr = fopen(fn_rej, resume? "a" : "w")) == 0) {
+		fprintf(stderr, "[E::%s] failed to open file '%s' for writing\n", __func__, fn_rej);
+		return 1;
+	}
+	if (fn_qc && (g.fpq = lt_qc_open(fn_qc, resume)) == 0) {
+		fprintf(stderr, "[E::%s] failed to open file '%s' for writing\n", __func__, fn_qc);
 		return 1;
 	}
 
-	fp = strcmp(argv[optind], "-")? gzopen(argv[optind], "r") : gzdopen(fileno(stdin), "r");
-	g.ks = kseq_init(fp);
+	if (g.fn_stats) {
+		g.st = (lt_stats_t*)malloc(sizeof(lt_stats_t));
+		lt_stats_init(g.st, g.bi->n);
+	}
 
-	kt_pipeline(2, worker_pipeline, &g, 3);
+	kt_pipeline_timed(g.opt.n_inflight, worker_pipeline, &g, LT_N_STEPS, g.fn_stats? g.wait : 0);
 
-	kseq_destroy(g.ks);
-	gzclose(fp);
+	if (lt_verbose >= 3) {
+		struct rusage r;
+		getrusage(RUSAGE_SELF, &r);
+		fprintf(stderr, "[M::%s] decompressed %.1f MB of input\n", __func__, (g.fp->n_bytes + (g.fp2? g.fp2->n_bytes : 0)) / 1048576.);
+		fprintf(stderr, "[M::%s] peak memory of the chunks in flight: %.1f MB; reading blocked %lld times for %.2f sec; peak RSS: %.1f MB\n", __func__,
+				g.mem.peak / 1048576., (long long)g.mem.n_blocked, g.mem.t_blocked, r.ru_maxrss / 1024.);
+	}
+	bseq_close(g.fp);
+	if (g.fp2) bseq_close(g.fp2);
+	if (g.fpo && (g.fpo->errcode || bgzf_close(g.fpo) != 0)) {
+		fprintf(stderr, "[E::%s] failed to write the output to '%s'\n", __func__, fn_out);
+		return 1;
+	}
+	if (g.fpq && (fclose(g.fpq) != 0 || g.qc_err)) {
+		fprintf(stderr, "[E::%s] failed to write the QC columns to '%s'\n", __func__, fn_qc);
+		return 1;
+	}
+	if (g.fpu && fclose(g.fpu) != 0) {
+		fprintf(stderr, "[E::%s] failed to write the unmerged output\n", __func__);
+		return 1;
+	}
+	if (g.fpr && fclose(g.fpr) != 0) {
+		fprintf(stderr, "[E::%s] failed to write the rejected pairs to '%s'\n", __func__, fn_rej);
+		return 1;
+	}
+	if (g.st) {
+		if (lt_stats_write(g.fn_stats, g.st, g.bi, g.fpu != 0, g.n_chunks, 1, g.t_start, g.wait, &g.mem, g.cells? g.cells->n : 0) != 0) {
+			fprintf(stderr, "[E::%s] failed to write statistics to '%s'\n", __func__, g.fn_stats);
+			return 1;
+		}
+		free(g.st->n_bc); free(g.st);
+	}
+	lt_mem_destroy(&g.mem);
+	free(g.cons);
+	lt_cells_destroy(g.cells);
+	lt_bcres_destroy(g.br);
+	lt_bcidx_destroy(g.bi);
 	return 0;
 }